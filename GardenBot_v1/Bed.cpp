@@ -1,25 +1,34 @@
 #include "Bed.h"
+#include "LogEvents.h"
+#include "Registry.h"
 
-extern void printTime();
-
-void BIOSDigitalSoilMeter::begin(char * name, unsigned long sensorAddress, byte minMoist, byte maxMoist) {
-  // set name
-  strcpy(this->name, name);
+void BIOSDigitalSoilMeter::begin(byte slot, unsigned long sensorAddress, byte minMoist, byte maxMoist) {
+  // name's in the registry
+  this->slot = slot;
   // set sensor address
-  this->sensorAddress = decodeAddress(sensorAddress);
+  this->sensorAddress = biosAddress(sensorAddress);
   // set targets
   setMoistureTargets(minMoist, maxMoist);
-  // at startup, set the current to not trigger alarms
-  this->currMoist = minMoist - 1;
+  // at startup, set the current to not trigger alarms.  a 4-bit field: 0 - 1 would be 15, too wet.
+  this->currMoist = this->minMoist > 0 ? this->minMoist - 1 : 0;
+  this->currTemp = 0;
 
   this->print();
 }
 
+// logged, not printed: this runs on every sensor update
 void BIOSDigitalSoilMeter::print() {
-  printTime();
-  Serial << F(": ") << this->name;
-  Serial << F(". Moisture curr[min/max]: ") << this->currMoist << F("[") << this->minMoist << F("/") << this->maxMoist << "]";
-  Serial << F(". Temp: ") << convertCtoF(this->currTemp) << F("F.") << endl;
+  char name[REGISTRY_NAME];
+  getName(name);
+  Log.event(LOG_SENSOR) << name << byte(this->currMoist) << byte(this->minMoist) << byte(this->maxMoist) << convertCtoF(getTemp());
+}
+
+void BIOSDigitalSoilMeter::getName(char *name) {
+  registrySensorName(this->slot, name);
+}
+
+void BIOSDigitalSoilMeter::setSlot(byte slot) {
+  this->slot = slot;
 }
 
 void BIOSDigitalSoilMeter::setMoistureTargets(byte minMoist, byte maxMoist) {
@@ -27,6 +36,13 @@ void BIOSDigitalSoilMeter::setMoistureTargets(byte minMoist, byte maxMoist) {
   this->maxMoist = maxMoist;
 }
 
+byte BIOSDigitalSoilMeter::getMoist() {
+  return ( this->currMoist );
+}
+float BIOSDigitalSoilMeter::getTemp() {
+  return ( this->currTemp / 10.0 );
+}
+
 boolean BIOSDigitalSoilMeter::tooDry() {
   return ( this->currMoist < this->minMoist );
 }
@@ -41,39 +57,18 @@ boolean BIOSDigitalSoilMeter::justRight() {
 // parse the message
 boolean BIOSDigitalSoilMeter::readMessage(unsigned long recv) {
 
-  if ( decodeAddress(recv) == this->sensorAddress ) {
-    this->currMoist = decodeMoist(recv);
-    this->currTemp = decodeTemp(recv);
+  if ( biosAddress(recv) == this->sensorAddress ) {
+    this->currMoist = biosMoist(recv);
+    this->currTemp = biosTemp(recv);
     this->print();
-    delay(DROP_REPEAT_DELAY);
     return ( true );
   } else {
     return ( false );
   }
 }
-// see http://rayshobby.net/reverse-engineer-a-cheap-wireless-soil-moisture-sensor/
-unsigned long BIOSDigitalSoilMeter::decodeAddress(unsigned long data) {
-  return ( getBits(data, 32, 9) );
-}
-float BIOSDigitalSoilMeter::decodeTemp(unsigned long data) {
-  int temp = getBits(data, 20, 12);
-  // stored as an 12-bit number with 2's complement math for negative values 
-
-  // check for sign bit
-  if( bitRead(temp, 11) ) {
-    // if there is one, left-pad with 1's.
-    temp |= 0b1111000000000000;
-  }
-  
-  return ( float(temp) / 10.0 );
-}
-byte BIOSDigitalSoilMeter::decodeMoist(unsigned long data) {
-  return ( getBits(data, 8, 4) );
-}
-
-void EtekcityOutlet::begin(char * name, unsigned long onCode, unsigned long offCode) {
-  // set name
-  strcpy(this->name, name);
+void EtekcityOutlet::begin(byte slot, unsigned long onCode, unsigned long offCode) {
+  // name's in the registry
+  this->slot = slot;
 
   // set pump codes
   this->onCode = onCode;
@@ -81,6 +76,7 @@ void EtekcityOutlet::begin(char * name, unsigned long onCode, unsigned long offC
 
   // pump state
   this->isOn = false;
+  this->runTime = 0;
 
   // show it
   this->print();
@@ -90,13 +86,28 @@ boolean EtekcityOutlet::on() {
   return( this->isOn );
 }
 
+unsigned long EtekcityOutlet::getRunTime() {
+  if ( this->isOn ) return( this->runTime + millis() - this->onSince );
+  return( this->runTime );
+}
+
+void EtekcityOutlet::resetRunTime() {
+  this->runTime = 0;
+  this->onSince = millis();
+}
+
+void EtekcityOutlet::setOn(boolean on) {
+  if ( on == this->isOn ) return;
+  if ( on ) this->onSince = millis();
+  else this->runTime += millis() - this->onSince;
+  this->isOn = on;
+  this->print();
+}
+
 // turn outlet on
 unsigned long EtekcityOutlet::turnOn() {
   // only update onTime and print if there's a change
-  if ( ! this->isOn ) {
-    this->isOn = true;
-    this->print();
-  }
+  setOn(true);
   
  return( this->onCode );
 }
@@ -104,27 +115,16 @@ unsigned long EtekcityOutlet::turnOn() {
 // turn outlet off
 unsigned long EtekcityOutlet::turnOff() {
   // only print if there's a change
-  if ( this->isOn ) {
-    this->isOn = false;
-    this->print();
-  }
+  setOn(false);
   return( this->offCode );
 }
 
 boolean EtekcityOutlet::readMessage(unsigned long recv) {
   if ( decodeAddress(recv) == this->onCode ) {
-    if ( !this->isOn ) {
-      this->isOn = true;
-      this->print();
-    }
-    delay(DROP_REPEAT_DELAY);
+    setOn(true);
     return ( true );
   } else if ( decodeAddress(recv) == this->offCode ) {
-    if ( this->isOn ) {
-      this->isOn = false;
-      this->print();
-    }
-    delay(DROP_REPEAT_DELAY);
+    setOn(false);
     return ( true );
   }
   return ( false );
@@ -136,18 +136,75 @@ unsigned long EtekcityOutlet::decodeAddress(unsigned long data) {
 
 // show pump parameters
 void EtekcityOutlet::print() {
-  printTime();
-  Serial << F(": ") << this->name;
-  Serial << F(". Status: ");
-  if (this->isOn) Serial << F("ON.");
-  else Serial << F("OFF.");
-  Serial << endl;
-}
-
-// helper function; leading and trailing bits; bitshift right
-unsigned long getBits(unsigned long data, int startBit, int nBits) {
-  const int dataLen = 32;
-  return ( ( data << (dataLen - startBit) ) >> (dataLen - nBits) );
+  char name[REGISTRY_NAME];
+  getName(name);
+  Log.event(LOG_OUTLET) << name << this->isOn;
+}
+
+void EtekcityOutlet::getName(char *name) {
+  registryPumpName(this->slot, name);
+}
+
+void EtekcityOutlet::setSlot(byte slot) {
+  this->slot = slot;
+}
+
+void PulseSoak::begin(unsigned int pulseSec, unsigned int soakMin, unsigned int minPulseSec, unsigned int maxPulseSec) {
+  this->pulseSec = pulseSec;
+  this->soakMin = soakMin;
+  this->minPulseSec = minPulseSec;
+  this->maxPulseSec = maxPulseSec;
+  reset();
+}
+
+void PulseSoak::reset() {
+  this->phase = PS_IDLE;
+  this->started = false;
+}
+
+boolean PulseSoak::busy() {
+  return( this->phase != PS_IDLE );
+}
+
+unsigned int PulseSoak::getPulseSec() {
+  return( this->pulseSec );
+}
+
+int PulseSoak::step(int wants, byte moist) {
+  unsigned long inPhase = millis() - this->phaseStart;
+
+  // wet enough: stop wherever we are
+  if ( wants < 0 ) {
+    reset();
+    return( -1 );
+  }
+
+  if ( this->phase == PS_PULSE ) {
+    if ( inPhase < this->pulseSec * 1000UL ) return( 1 );
+    this->phase = PS_SOAK;
+    this->phaseStart = millis();
+    return( -1 );
+  }
+
+  if ( this->phase == PS_SOAK ) {
+    if ( inPhase < this->soakMin * 60000UL ) return( -1 );
+    // still short of wet after the soak.  adapt to what the last pulse did:
+    // no change at the sensor, the pulse was too small to reach it; a jump of more than one step, too big.
+    if ( moist <= this->moistBefore ) this->pulseSec += this->pulseSec / 4;
+    else if ( moist > this->moistBefore + 1 ) this->pulseSec -= this->pulseSec / 4;
+    this->pulseSec = constrain(this->pulseSec, this->minPulseSec, this->maxPulseSec);
+    this->phase = PS_IDLE;
+  }
+
+  // idle: start a pulse if the beds are dry, or if we're partway through watering them
+  if ( wants > 0 || this->started ) {
+    this->started = true;
+    this->phase = PS_PULSE;
+    this->phaseStart = millis();
+    this->moistBefore = moist;
+    return( 1 );
+  }
+  return( 0 );
 }
 
 float convertCtoF(float c) {
@@ -1,14 +1,15 @@
 #ifndef Bed_h
 #define Bed_h
 
-#define DROP_REPEAT_DELAY 1000UL // messages are received with repeats.  If we get a good one, wait so we drop the extra.
-
 #include <Arduino.h>
 #include <Streaming.h> // this needs to be #include'd in the .ino file, too.
+#include <RadioRx.h> // the TB304BC frame's fields
 
+// one per bed, and there are up to MAX_SENSORS (Registry.h) of them, so it's packed: 6 bytes.
+// the name stays in the EEPROM registry, in entry slot.
 class BIOSDigitalSoilMeter {
   public:
-    void begin(char name[], unsigned long sensorAddress, byte minMoist=6, byte maxMoist=11);
+    void begin(byte slot, unsigned long sensorAddress, byte minMoist=6, byte maxMoist=11);
                
     // accessor functions
     // get current moisture
@@ -28,36 +29,35 @@ class BIOSDigitalSoilMeter {
     // sets targets    
     void setMoistureTargets(byte minMoist, byte maxMoist);
        
-    // store sensor name
-    char name[20];
+    // sensor name, from the registry; REGISTRY_NAME bytes
+    void getName(char *name);
+    // the registry entry moved
+    void setSlot(byte slot);
   
     // show sensor parameters
     void print();
 
 private:    
-    // store the sensor address code
-    unsigned long sensorAddress;
-    
-    // min target, max target, current moisture level. 0-3 (dry), 4-7 (damp), 8-11 (wet)
-    byte minMoist, maxMoist, currMoist;
+    // sensor address code: 9 bits.
+    // min target, max target, current moisture level: 4 bits each. 0-3 (dry), 4-7 (damp), 8-11 (wet)
+    // registry slot: 6 bits.
+    unsigned long sensorAddress:9, minMoist:4, maxMoist:4, currMoist:4, slot:6;
     
-    // current temperature
-    float currTemp;
-    
-    // handles the sensor data packet
-    unsigned long decodeAddress(unsigned long data);
-    float decodeTemp(unsigned long data);
-    byte decodeMoist(unsigned long data);
+    // current temperature, in tenths of a degree C, as sent
+    int currTemp;
     
 };
  
  class EtekcityOutlet {
    public:
-    void begin(char name[], unsigned long onCode, unsigned long offCode);
+    void begin(byte slot, unsigned long onCode, unsigned long offCode);
               
     // accessor functions 
     // return current outlet state; true==on, false==off
     boolean on();
+    // ms the outlet has been on since the last resetRunTime(), including any current run
+    unsigned long getRunTime();
+    void resetRunTime();
 
     // return message required to outlet on and off
     unsigned long turnOn();
@@ -69,24 +69,57 @@ private:
     // show outlet parameters
     void print();
     
-    // store outlet name
-    char name[20];
+    // outlet name, from the registry; REGISTRY_NAME bytes
+    void getName(char *name);
+    // the registry entry moved
+    void setSlot(byte slot);
 
   private:
+    byte slot;
 
     // store the outlet address codes
     unsigned long onCode, offCode;
     
     // store the outlet state
     boolean isOn;
+    
+    // runtime bookkeeping; set the state through here so it's counted
+    unsigned long onSince, runTime;
+    void setOn(boolean on);
 
     // handles the outlet data packet
     unsigned long decodeAddress(unsigned long data);
    
 };
 
+// pulse/soak irrigation for one pump group: run the pump for a pulse, let it soak in, repeat
+// until the beds are right.  clay takes water slowly, so short pulses run off less than one long run.
+// the pulse length adapts from how the driest bed responded to the last pulse.
+class PulseSoak {
+  public:
+    void begin(unsigned int pulseSec=60, unsigned int soakMin=10, unsigned int minPulseSec=20, unsigned int maxPulseSec=300);
+
+    // start of a watering cycle
+    void reset();
+
+    // what the pump should do now: 1 on, -1 off, 0 leave it.
+    // wants is the beds' verdict (1 too dry, -1 wet enough, 0 in between); moist is the driest bed's reading.
+    int step(int wants, byte moist);
+
+    // is a pulse or soak under way?
+    boolean busy();
+
+    unsigned int getPulseSec();
+
+  private:
+    enum { PS_IDLE, PS_PULSE, PS_SOAK } phase;
+    boolean started; // true once this cycle has pulsed; keep going through the in-between band
+    unsigned long phaseStart;
+    unsigned int pulseSec, soakMin, minPulseSec, maxPulseSec;
+    byte moistBefore;
+};
+
 // helper functions
-unsigned long getBits(unsigned long data, int startBit, int nBits) ;
 float convertCtoF(float c);
 float convertFtoC(float f);
 float computeHeatIndex(float tempFahrenheit, float percentHumidity);
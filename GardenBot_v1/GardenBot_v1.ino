@@ -2,49 +2,153 @@
 #include <Metro.h>
 #include <DS3231.h> // see AT24C32_TEST example for I2C memory (32k) for logging
 #include <Wire.h>
+#include <avr/sleep.h>
+
+// state changes go out as binary records (see BinLog.h); a host decoder turns them back into text
+#include <BinLog.h>
+#include "LogEvents.h"
+LOG_EVENTS(BINLOG_STRING)
+const char * const logFormats[] PROGMEM = { LOG_EVENTS(BINLOG_POINTER) };
 
 // configure RTC
 DS3231 rtc;
+#define RTCINTPIN 3 // DS3231 INT/SQW; D3 is int.1
 
-// radio abstraction
+// radio abstraction.  receiving is the RadioRx library, shared with the other sketches.
+#include <RadioRx.h>
 #include "Radio.h"
 
 #define RXPIN 2
 #define TXPIN 10
 Radio radio;
 
+// learning mode: send "l" to start and stop.  turns raw captures into protocol tables and codes to
+// paste in here, for a new outlet or sensor.  tools/radiosniff does the same with the "Sniff raw:" lines.
+#include <RadioSniff.h>
+#if RADIO_SNIFF_EDGES > 0
+RadioSniff sniffer;
+#endif
+
 // sensor and pump abstraction
 #include "Bed.h"
 
+// the beds and pumps come from the registry in EEPROM (see Registry.h, and registryDefaults() for
+// the first boot).  change them over serial; see registryCommand().
+#include "Registry.h"
+
 // how many sensors are we reading?
-const int nSensors = 2;
-BIOSDigitalSoilMeter sensor[nSensors];
+int nSensors = 0;
+BIOSDigitalSoilMeter sensor[MAX_SENSORS];
 
 // how many pumps are we controlling?
-const int nPumps = 1;
-EtekcityOutlet pump[nPumps];
+int nPumps = 0;
+EtekcityOutlet pump[MAX_PUMPS];
 
 // what pumps water which sensors?
-const boolean ps[nSensors] = {0, 0};
+byte ps[MAX_SENSORS];
+
+// which pumps water in pulses with soaks between (see PulseSoak in Bed.h), rather than running until the beds are right
+boolean pulsed[MAX_PUMPS];
+PulseSoak pulse[MAX_PUMPS];
 
 // use LED to indicate status, with morse
 // "d": one or more sensors is reporting too dry
 // "w": watering in progress
 // SOS: a sensor is acting whacky
 #define LED 13
+// the morse plays from loop(), a step at a time in ledUpdate(), so nothing waits on the LED
+const char *ledWord = 0;  // letters still to play, or 0 when it's quiet
+const char *ledCode = ""; // dots and dashes of the current letter still to play
+boolean ledLit = false;
+unsigned long ledAt, ledFor; // the current step started, and lasts (ms)
 
 // define a maximum watering time, in hours
 unsigned long maxWaterTime = 6; // hr
 Metro maxTimeReached(maxWaterTime * 60UL * 60UL * 1000UL); // hr -> ms
 
+// the watering cycle is a state machine, so loop() keeps running while it waters:
+// Idle -> Evaluate -> Pumping -> Soak -> Verify -> Done, or Fault if it runs too long.
+#include <TableStateMachine.h>
+
+// events
+#define EV_ALARM 1  // RTC watering alarm
+#define EV_MANUAL 2 // someone used a pump's remote
+
+// stagger pump starts; power draw on the pumps is high at startup
+#define PUMP_STAGGER 1000UL // ms
+// after the pumps stop, let the water soak in before believing the sensors
+#define SOAK_TIME (20UL * 60UL * 1000UL) // ms
+
+unsigned long wateringStart;
+// the last pump change, for PUMP_STAGGER.  set back by a stagger on entering a state, so its first change is right away
+unsigned long staggerLast;
+// a pump has been started since Pumping was entered
+boolean pumpRan;
+// pumps Done still has to send "off" to
+byte pumpsToStop;
+
+void evaluateEnter();
+void pumpingEnter();
+void pumpingUpdate();
+void soakEnter();
+void faultEnter();
+void doneEnter();
+void doneUpdate();
+void printSensors();
+boolean needsWater();
+boolean pumpsFinished();
+boolean pumpsStopped();
+boolean maxTimeUp();
+
+State idle(NO_ENTER, NO_UPDATE, NO_EXIT);
+State evaluate(evaluateEnter, NO_UPDATE, NO_EXIT);
+State pumping(pumpingEnter, pumpingUpdate, NO_EXIT);
+State soak(soakEnter, NO_UPDATE, NO_EXIT);
+State verify(printSensors, NO_UPDATE, NO_EXIT);
+State fault(faultEnter, NO_UPDATE, NO_EXIT);
+State done(doneEnter, doneUpdate, NO_EXIT);
+
+const Transition wateringTable[] PROGMEM = {
+  // from, event, after (ms), guard, to
+  { &idle,     EV_ALARM,  0,            NO_GUARD,    &evaluate },
+  { &evaluate, FSM_TIMED, 0,            needsWater,  &pumping },
+  { &evaluate, FSM_TIMED, 0,            NO_GUARD,    &done },
+  { &pumping,  EV_MANUAL, 0,            NO_GUARD,    &done },
+  { &pumping,  FSM_TIMED, 0,            maxTimeUp,   &fault },
+  { &pumping,  FSM_TIMED, PUMP_STAGGER, pumpsFinished, &soak },
+  { &soak,     EV_MANUAL, 0,            NO_GUARD,    &done },
+  { &soak,     FSM_TIMED, 0,            maxTimeUp,   &fault },
+  { &soak,     FSM_TIMED, SOAK_TIME,    NO_GUARD,    &verify },
+  { &verify,   FSM_TIMED, 0,            needsWater,  &pumping },
+  { &verify,   FSM_TIMED, 0,            NO_GUARD,    &done },
+  { &fault,    FSM_TIMED, 0,            NO_GUARD,    &done },
+  { &done,     FSM_TIMED, 0,            pumpsStopped, &idle }
+};
+TableStateMachine watering(idle, wateringTable, sizeof(wateringTable) / sizeof(Transition));
+
 // show radio messages.  useful for figuring out addresses.
 #define DEBUG_RADIO true
+// log the radio's link-quality counters this often, then start them over.  send "r" for them any time.
+#define LINK_REPORT_INTERVAL (15UL * 60UL * 1000UL) // ms
+
+// idle between events.  SLEEP_MODE_IDLE only stops the CPU clock: timer0 keeps
+// millis() (and so every Metro) running, and the radio and RTC pin interrupts and
+// serial RX all still wake us.  power-save would stop timer0 and the UART.
+#define SLEEP_IDLE true
+// report awake/asleep share this often, for estimating battery life
+#define POWER_REPORT_INTERVAL (60UL * 60UL * 1000UL) // ms
+// supply current awake and in idle.  measure these on your own board.
+#define AWAKE_mA 15.0
+#define IDLE_mA 6.0
+unsigned long sleepMicros = 0; // time spent in idle since the last report
+unsigned long nWakes = 0;
 
 void setup() {
   Serial.begin(115200);
 
   Serial << F("Startup.") << endl;
   Serial.setTimeout(10);
+  Log.begin(Serial, logFormats, LOG_NEVENTS);
 
   // LED pin
   pinMode(LED, OUTPUT);
@@ -60,9 +164,7 @@ void setup() {
     Serial << F("RTC oscillator problem...") << endl;
     rtc.setSecond(rtc.getSecond());
   }
-  Serial << F("RTC: Time=");
-  printTime();
-  Serial << endl;
+  logClock();
 
   // Timers
   // 9pm. when hour, min, sec match.
@@ -78,33 +180,36 @@ void setup() {
   // send 20,59,45,4,27,11 to simulate a watering run.
   rtc.turnOnAlarm(1);
   Serial << F("Watering alarm enabled? ") << rtc.checkAlarmEnabled(1) << endl;
+  // alarm arrives on the INT pin instead of being polled over I2C
+  if ( !rtc.attachAlarmInterrupt(RTCINTPIN) ) {
+    Serial << F("RTC: error. INT pin must be 2 or 3.") << endl;
+  }
 
   // Radio module
   radio.begin(RXPIN, TXPIN);
   radio.txRepeat(5); // 5 repeats
   radio.txProtocol(1); // always tranmitting using protocol 1 (ETek outlets)
-
-  // pumps
+  // setup logs more than the ring holds; send it before carrying on
+  Log.flush();
+
+  // pumps and sensors
+  RegistryHeader h;
+  if ( !registryBegin(h) ) {
+    Serial << F("Registry: nothing good in EEPROM; using the defaults.") << endl;
+    registryDefaults(h);
+  }
   Serial << F("Pumps:") << endl;
-  pump[0].begin("Pump 1", 1381683, 1381692);
-
-  //  pump[1].begin("Pump 2", 1381827, 1381836);
-  //  pump[2].begin("Pump 3", 1382147, 1382156);
-  //  pump[3].begin("Pump 4", 1383683, 1383692);
-  //  pump[4].begin("Pump 5", 1389827, 1389836);
-
-  // sensors
+  for ( byte p = 0; p < h.nPumps; p++ ) registryPump(h, p);
   Serial << F("Sensors:") << endl;
-  //  sensor[0].begin("South Bed", 324, 6, 10);
-  //  sensor[1].begin("West Bed", 868, 6, 10);
-  sensor[0].begin("South Bed", 910207744, 3, 5);
-  sensor[1].begin("West Bed", 339785730, 3, 5);
-  //  sensor[2].begin("Flower Bed", 1949, 4, 8);   // try to keep this bed drier
+  for ( byte s = 0; s < h.nSensors; s++ ) registrySensor(h, s);
 
   // pump and sensor relationships
   Serial << F("Pump waters Sensors:") << endl;
   for ( int i = 0; i < nSensors; i++ ) {
-    Serial << pump[ps[i]].name << F(" waters ") << sensor[i].name << endl;
+    char pumpName[REGISTRY_NAME], bedName[REGISTRY_NAME];
+    pump[ps[i]].getName(pumpName);
+    sensor[i].getName(bedName);
+    Serial << pumpName << F(" waters ") << bedName << endl;
   }
   
   Serial << F("Turning pumps off.") << endl;
@@ -117,17 +222,31 @@ void setup() {
   boolean alarm = rtc.checkIfAlarm(1);
   Serial << F("Clearing alarm flag.  Was ") << alarm << endl;
 
+  Log.flush();
   Serial << F("Startup complete.") << endl;
 
 }
 
 void loop() {
 
+  // hand queued log records to the UART
+  Log.poll();
+
+  // next step of any morse on the LED
+  ledUpdate();
+
   // look for sensor data
   getSensorData();
 
-  // look for pump manual control
-  if( notePumpManualControl() ) {
+  // step the watering cycle
+  watering.update();
+
+  // look for pump manual control.  during a watering cycle, that ends the cycle.
+  boolean manualControl = notePumpManualControl();
+  if( manualControl && watering.raise(EV_MANUAL) ) {
+    printTime();
+    Serial << F(": manual control noted.  Stopping watering cycle.") << endl;
+  } else if( manualControl ) {
     printTime();
     Serial << F(": manual control noted.") << endl;
     for (int p = 0; p < nPumps; p++ ) {
@@ -143,7 +262,8 @@ void loop() {
     }
   }
 
-  if ( maxTimeReached.check() ) {
+  // the watering cycle watches maxTimeReached itself while it runs
+  if ( watering.isInState(idle) && maxTimeReached.check() ) {
     printTime();
     Serial << F(": watering time interval.  Stopping any active pumps.") << endl;
 
@@ -152,19 +272,15 @@ void loop() {
 
   // if we still can't process the message, print it,  probably just need to add it in the setup().  Drop decimel code in.
   if ( radio.rxAvailable() && DEBUG_RADIO ) {
-    Serial << F("Radio: unknown receipt.  Protocol: ") << radio.rxProtocol();
-    Serial << F(" Bit Length: ") << radio.rxBitLength();
-    Serial << F(" Message (dec): ") << radio.rxMessage();
-    Serial << F(" Message (bin): ") << dec2binWzerofill(radio.rxMessage(), 32);
-    Serial << endl;
+    Log.event(LOG_FRAME) << radio.rxProtocol() << radio.rxBitLength() << radio.rxMessage();
     radio.rxClear();
   }
 
   /*
   if( DEBUG_RADIO ) {
-    extern volatile unsigned long ISR_rxVal;
-    if( ISR_rxVal > 0b1000000000000000 ) {
-      Serial << F(" rxVal: (bin): ") << dec2binWzerofill(ISR_rxVal, 32) << endl;
+    extern RadioChannel channel[NPROT];
+    if( channel[0].rxVal > 0b1000000000000000 ) {
+      Serial << F(" rxVal: (bin): ") << dec2binWzerofill(channel[0].rxVal, 32) << endl;
       delay(50);
     }
   }
@@ -173,6 +289,9 @@ void loop() {
   // check for time update from Serial
   getTimeUpdate();
 
+  // learning mode
+  learn();
+
   // monitor for too dry
   boolean tooDry = false;
   for (int s = 0; s < nSensors; s++ ) {
@@ -188,92 +307,143 @@ void loop() {
     ledTooDry();
   }
 
-  // check alarm for Watering time
-  static Metro checkAlarm(1000UL); // every second.
-  if ( checkAlarm.check() ) {
-    checkAlarm.reset();
-    // the RTC needs to be polled on an interval to actually set alarm flag.
-    byte toss = rtc.getSecond();
-    if ( rtc.checkIfAlarm(1) ) {
-      wateringTime();
+  // check alarm for Watering time.  only touches the I2C bus once INT has fired.
+  if ( rtc.alarmLatched() && rtc.checkIfAlarm(1) ) {
+    Log.event(LOG_ALARM);
+    watering.raise(EV_ALARM);
+  }
+
+  // nothing is transmitting by the time we get here: that blocks.
+  // stay awake through a watering cycle, and while the LED is playing.
+  powerReport();
+  linkReport();
+  if ( SLEEP_IDLE && watering.isInState(idle) && !ledBusy() ) idleSleep();
+}
+
+// what pump p should do, from the sensors it waters: 1 on, -1 off, 0 leave it.
+//
+// generally, we want to water infrequently, but heavily if we do.
+// so, only turn on the pumps if the soil reads "too dry", but then run the pumps until just short of "too wet" (justRight)
+int pumpWants(int p) {
+  boolean tooDry = false;
+  boolean tooWet = false;
+  boolean justRight = true;
+  // check each sensor assigned to this pump
+  for (int s = 0; s < nSensors; s++ ) {
+    if ( ps[s] == p ) { // if this pump waters this sensor
+      if ( sensor[s].tooDry() ) tooDry |= true;
+      if ( sensor[s].tooWet() ) tooWet |= true;
+      if ( !sensor[s].justRight() ) justRight &= false; // hard to get them all just right with one pump
     }
   }
+  if ( tooWet || justRight ) return( -1 );
+  if ( tooDry ) return( 1 );
+  return( 0 );
+}
+
+// guards
+boolean needsWater() {
+  for (int p = 0; p < nPumps; p++ ) {
+    if ( pumpWants(p) > 0 ) return( true );
+  }
+  return( false );
+}
+
+// the driest reading among the sensors pump p waters
+byte driestMoist(int p) {
+  byte driest = 255;
+  for (int s = 0; s < nSensors; s++ ) {
+    if ( ps[s] == p && sensor[s].getMoist() < driest ) driest = sensor[s].getMoist();
+  }
+  return( driest );
+}
+
+// all pumps off, and none of them partway through a pulse/soak
+boolean pumpsResting() {
+  for (int p = 0; p < nPumps; p++ ) {
+    if ( pump[p].on() || pulse[p].busy() ) return( false );
+  }
+  return( true );
+}
+
+// a pump has run, and they've all stopped
+boolean pumpsFinished() {
+  return( pumpRan && pumpsResting() );
+}
 
+boolean pumpsStopped() {
+  return( pumpsToStop == 0 );
 }
 
-void wateringTime() {
+boolean maxTimeUp() {
+  return( maxTimeReached.check() );
+}
+
+// true at most once per PUMP_STAGGER
+boolean staggerDue() {
+  if ( millis() - staggerLast < PUMP_STAGGER ) return( false );
+  staggerLast = millis();
+  return( true );
+}
+
+// states
+void evaluateEnter() {
   printTime();
   Serial << F(": Watering time.") << endl;
 
   // track the start time for this cycle
-  unsigned long now = millis();
+  wateringStart = millis();
   maxTimeReached.reset();
+  for (int p = 0; p < nPumps; p++ ) {
+    pulse[p].reset();
+    pump[p].resetRunTime();
+  }
 
   // where are we?
   printSensors();
+}
 
-  boolean keepWatering = true;
-  while ( keepWatering ) {
-    // watch the radio
-    getSensorData();
-    boolean manualControl = notePumpManualControl();
-
-    // indicate watering cycle
-    ledWatering();
+void pumpingEnter() {
+  pumpRan = false;
+  staggerLast = millis() - PUMP_STAGGER;
+  // indicate watering cycle
+  ledWatering();
+}
 
-    // work through each pump
-    for (int p = 0; p < nPumps; p++ ) {
+// one pump change per PUMP_STAGGER, so start-up draws don't overlap
+void pumpingUpdate() {
+  if ( !staggerDue() ) return;
 
-      boolean tooDry = false;
-      boolean tooWet = false;
-      boolean justRight = true;
-      // check each sensor assigned to this pump
-      for (int s = 0; s < nSensors; s++ ) {
-        if ( ps[s] == p ) { // if this pump waters this sensor
-          if ( sensor[s].tooDry() ) tooDry |= true;
-          if ( sensor[s].tooWet() ) tooWet |= true;
-          if ( !sensor[s].justRight() ) justRight &= false; // hard to get them all just right with one pump
-        }
-      }
-      //      Serial << "pump:" << p << " on?" << pump[p].isOn << " tooDry?" << tooDry << " tooWet?" << tooWet << endl;
-
-      // examine the results, and decide what to do.
-      //
-      // generally, we want to water infrequently, but heavily if we do.
-      // so, only turn on the pumps if the soil reads "too dry", but then run the pumps until just short of "too wet" (justRight)
-
-      //      if ( tooWet || !tooDry ) {
-      if ( tooWet || justRight ) {
-        //        Serial << "too wet or not too dry" << endl;
-        radio.txMessage(pump[p].turnOff());
-      } else if ( tooDry ) {
-        //       Serial << "too dry" << endl;
-        radio.txMessage(pump[p].turnOn());
-        delay(1000); // power draw on the pumps is high at startup.  stagger them.
-      }
+  for (int p = 0; p < nPumps; p++ ) {
+    int wants = pumpWants(p);
+    if ( pulsed[p] ) wants = pulse[p].step(wants, driestMoist(p));
+    if ( wants < 0 && pump[p].on() ) {
+      radio.txMessage(pump[p].turnOff());
+      return;
     }
-
-    // check to see if all pumps are off.  If they are, we're done for the night.
-    keepWatering = false;
-    for (int p = 0; p < nPumps; p++ ) keepWatering |= pump[p].on();
-
-    //    delay(1000);
-    if ( maxTimeReached.check() ) {
-      Serial << F("BAD: maximum watering time reached.  Shutting down...") << endl;
-      pumpsAllOff();
-      keepWatering = false;
+    if ( wants > 0 && !pump[p].on() ) {
+      radio.txMessage(pump[p].turnOn());
+      pumpRan = true;
+      return;
     }
-    
-    if( manualControl ) {
-      Serial << F("Noted manual control.  Shutting down...") << endl;
-      pumpsAllOff();
-      keepWatering = false;
-    } 
   }
+}
 
-  // just in case
-  pumpsAllOff();
-  Serial << F("All pumps off.  Watering cycle complete.") << endl;
+void soakEnter() {
+  printTime();
+  Serial << F(": pumps off, soaking for ") << SOAK_TIME / 60000UL << F(" minutes.") << endl;
+}
+
+void faultEnter() {
+  Serial << F("BAD: maximum watering time reached.  Shutting down...") << endl;
+  ledSOS();
+}
+
+void doneEnter() {
+  // just in case: every pump gets an "off", one per PUMP_STAGGER from doneUpdate()
+  pumpsToStop = nPumps;
+  staggerLast = millis() - PUMP_STAGGER;
+  Serial << F("Shutting down all pumps.  Watering cycle complete.") << endl;
 
   // see where we ended up.
   boolean tooDry = false;
@@ -286,8 +456,18 @@ void wateringTime() {
     Serial << F("GOOD: no sensors report 'too dry' after watering.") << endl;
   }
   printSensors();
-  Serial << F("Total watering time: ") << (millis() - now) / 1000 / 60 << F(" minutes.") << endl;
+  Serial << F("Total watering time: ") << (millis() - wateringStart) / 1000 / 60 << F(" minutes.") << endl;
+  for (int p = 0; p < nPumps; p++ ) {
+    char name[REGISTRY_NAME];
+    pump[p].getName(name);
+    Log.event(LOG_PUMP_RUN) << name << pump[p].getRunTime() / 1000 << ( pulsed[p] ? pulse[p].getPulseSec() : 0U );
+  }
+}
 
+void doneUpdate() {
+  if ( pumpsToStop == 0 || !staggerDue() ) return;
+  pumpsToStop--;
+  radio.txMessage(pump[pumpsToStop].turnOff());
 }
 
 boolean notePumpManualControl() {
@@ -326,10 +506,27 @@ void getTimeUpdate() {
   while (Serial.available() > 0) {
     // wait for everything to come in.
     delay(25);
+    // radio link quality since the last report
+    if ( Serial.peek() == 'r' ) {
+      radio.printStats();
+      while ( Serial.read() > -1); // dump anything trailing.
+      return;
+    }
+    // beds and pumps
+    if ( Serial.peek() == 'd' || Serial.peek() == 's' || Serial.peek() == 'p' || Serial.peek() == 'x' ) {
+      registryCommand();
+      return;
+    }
+    // learning mode on/off
+    if ( Serial.peek() == 'l' ) {
+      learnToggle();
+      while ( Serial.read() > -1); // dump anything trailing.
+      return;
+    }
     // check for valid character
     if ( Serial.peek() < '0' || Serial.peek() > '9' ) {
       // bad request.
-      Serial << F("Bad time setting.  Format: hr, min, sec, day, month, year") << endl;
+      Serial << F("Bad time setting.  Format: hr, min, sec, day, month, year.  Or r for radio stats, l for learning mode, d s p x for beds and pumps.") << endl;
       while ( Serial.read() > -1); // dump anything trailing.
       return;
     }
@@ -357,106 +554,429 @@ void getTimeUpdate() {
 }
 
 
+// idle until the next interrupt, unless there's work already waiting.
+void idleSleep() {
+  set_sleep_mode(SLEEP_MODE_IDLE);
+  // interrupts off across the check, so a frame or byte arriving just after it still wakes us.
+  // sleep_cpu() right after sei runs before any pending interrupt is taken.
+  noInterrupts();
+  if ( radio.rxAvailable() || Serial.available() > 0 || digitalRead(RTCINTPIN) == LOW ) {
+    interrupts();
+    return;
+  }
+  unsigned long start = micros();
+  sleep_enable();
+  interrupts();
+  sleep_cpu();
+  sleep_disable();
+  sleepMicros += micros() - start;
+  nWakes++;
+}
+
+// awake share since the last report, and the average current it implies.
+void powerReport() {
+  static Metro reportPower(POWER_REPORT_INTERVAL);
+  static unsigned long lastReport = 0;
+  if ( !reportPower.check() ) return;
+  // Metro replays every interval missed while loop() was held up; one report covers them all
+  reportPower.reset();
+
+  unsigned long now = millis();
+  float period = (now - lastReport) * 1000.0; // us
+  float awake = 1.0 - sleepMicros / period;
+  printTime();
+  Serial << F(": Power: awake ") << awake * 100.0 << F("% of ") << (now - lastReport) / 1000UL << F(" s, ");
+  Serial << nWakes << F(" wakes, ~") << awake * AWAKE_mA + (1.0 - awake) * IDLE_mA << F(" mA average") << endl;
+
+  lastReport = now;
+  sleepMicros = 0;
+  nWakes = 0;
+
+  // ties the log's millis() stamps to the clock
+  logClock();
+}
+
+// radio counters into the log, for placing antennas and telling a dead sensor from a noisy band
+void linkReport() {
+  static Metro reportLink(LINK_REPORT_INTERVAL);
+  if ( !reportLink.check() ) return;
+  reportLink.reset();
+
+  for (byte p = 0; p < NPROT; p++ ) {
+    RadioStats st;
+    radio.getStats(p, st);
+    Log.event(LOG_LINK) << p << st.syncs << st.frames << st.busy << st.repeats << st.badHigh << st.badLow << radio.getUnit(p);
+  }
+  Log.event(LOG_NOISE) << radio.getNoise();
+  radio.clearStats();
+}
+
+#if RADIO_SNIFF_EDGES > 0
+void printSniffProtocol(byte i) {
+  const SniffProtocol &p = sniffer.getProtocol(i);
+  Serial << F("Sniff: protocol ") << i << F(" from ") << p.frames << F(" frames. As a RadioProtocol: ");
+  Serial << F("{ ") << p.bits << F(", ") << p.pulseLength;
+  Serial << F(", { ") << p.sync[0] << F(", ") << p.sync[1] << F(" }");
+  Serial << F(", { ") << p.zero[0] << F(", ") << p.zero[1] << F(" }");
+  Serial << F(", { ") << p.one[0] << F(", ") << p.one[1] << F(" } }") << endl;
+}
+
+void printSniffCode(byte c) {
+  const SniffCode &code = sniffer.getCode(c);
+  Serial << F("Sniff: protocol ") << code.protocol << F(" code ") << code.code << F(" seen ") << code.count << endl;
+}
+
+// start learning, or stop and show what was learned
+void learnToggle() {
+  if ( radio.sniffing() ) {
+    radio.sniff(false);
+    for (byte i = 0; i < sniffer.getProtocols(); i++) printSniffProtocol(i);
+    for (byte c = 0; c < sniffer.getCodes(); c++) printSniffCode(c);
+    Serial << F("Sniff: off. ") << sniffer.getRejected() << F(" captures weren't frames.") << endl;
+  } else {
+    sniffer.clear();
+    radio.sniff(true);
+    Serial << F("Sniff: on. Press the remote, or wait for the sensor; l again to stop.") << endl;
+  }
+}
+
+// each capture goes out raw, for tools/radiosniff, and then through the sniffer.  new protocols and
+// codes are shown as they turn up.
+void learn() {
+  const unsigned int *edges;
+  byte n = radio.sniffCapture(edges);
+  if ( n == 0 ) return;
+
+  Serial << F("Sniff raw:");
+  for (byte i = 0; i < n; i++) Serial << (i ? F(",") : F(" ")) << edges[i];
+  Serial << endl;
+
+  byte protocols = sniffer.getProtocols();
+  int c = sniffer.add(edges, n);
+  radio.sniffNext();
+
+  if ( c < 0 ) return;
+  if ( sniffer.getProtocols() > protocols ) printSniffProtocol(sniffer.getCode(c).protocol);
+  if ( sniffer.getCode(c).count == 1 ) printSniffCode(c);
+}
+#else
+void learnToggle() {
+  Serial << F("Sniff: RADIO_SNIFF_EDGES is 0.") << endl;
+}
+
+void learn() {}
+#endif
+
+// what's compiled in, for the first boot, or when the EEPROM copy is bad
+void registryDefaults(RegistryHeader &h) {
+  registryFormat(h);
+
+  PumpEntry p;
+  memset(&p, 0, sizeof(p));
+  strcpy(p.name, "Pump 1");
+  p.onCode = 1381683;
+  p.offCode = 1381692;
+  // 60 s pulses, 10 min soaks; pulses adapt between 20 s and 5 min
+  p.pulsed = true;
+  p.pulseSec = 60;
+  p.soakMin = 10;
+  p.minPulseSec = 20;
+  p.maxPulseSec = 300;
+  registryPut(h.nPumps++, p);
+  //  Pump 2: 1381827, 1381836
+  //  Pump 3: 1382147, 1382156
+  //  Pump 4: 1383683, 1383692
+  //  Pump 5: 1389827, 1389836
+
+  SensorEntry s;
+  memset(&s, 0, sizeof(s));
+  strcpy(s.name, "South Bed");
+  s.code = 910207744;
+  s.minMoist = 3;
+  s.maxMoist = 5;
+  s.pump = 0;
+  registryPut(h.nSensors++, s);
+  strcpy(s.name, "West Bed");
+  s.code = 339785730;
+  registryPut(h.nSensors++, s);
+  //  Flower Bed: 1949, 4, 8   // try to keep this bed drier
+
+  registryPutHeader(h);
+  registrySeal();
+}
+
+// (re)start pump p, or sensor s, from the registry
+void registryPump(RegistryHeader &h, byte p) {
+  PumpEntry e;
+  registryGet(p, e);
+  pump[p].begin(p, e.onCode, e.offCode);
+  pulsed[p] = e.pulsed;
+  pulse[p].begin(e.pulseSec, e.soakMin, e.minPulseSec, e.maxPulseSec);
+  nPumps = h.nPumps;
+}
+
+void registrySensor(RegistryHeader &h, byte s) {
+  SensorEntry e;
+  registryGet(s, e);
+  sensor[s].begin(s, e.code, e.minMoist, e.maxMoist);
+  ps[s] = e.pump;
+  nSensors = h.nSensors;
+}
+
+void registryPrint(RegistryHeader &h) {
+  for ( byte p = 0; p < h.nPumps; p++ ) {
+    PumpEntry e;
+    registryGet(p, e);
+    Serial << F("Registry: pump ") << p << F(" ") << e.name << F(", codes on ") << e.onCode << F(" off ") << e.offCode;
+    Serial << F(", pulsed ") << e.pulsed << endl;
+  }
+  for ( byte s = 0; s < h.nSensors; s++ ) {
+    SensorEntry e;
+    registryGet(s, e);
+    Serial << F("Registry: bed ") << s << F(" ") << e.name << F(", code ") << e.code;
+    Serial << F(", moisture ") << e.minMoist << F("-") << e.maxMoist << F(", pump ") << e.pump << endl;
+  }
+}
+
+// the rest of the line, trimmed, as a name.  false if there's none.
+boolean registryName(char *name, char *text) {
+  while ( *text == ' ' || *text == ',' ) text++;
+  byte n = 0;
+  while ( text[n] && text[n] != '\r' && n < REGISTRY_NAME - 1 ) n++;
+  while ( n > 0 && text[n - 1] == ' ' ) n--;
+  if ( n == 0 ) return ( false );
+  memset(name, 0, REGISTRY_NAME);
+  memcpy(name, text, n);
+  return ( true );
+}
+
+// registry changes over serial.  each is saved to EEPROM, and only the bed or pump changed is restarted.
+//   d                                       list the beds and pumps
+//   s bed code minMoist maxMoist pump name  change a bed, or add one as bed number nSensors
+//   p pump onCode offCode pulsed name       change a pump, or add one as pump number nPumps
+//   x s bed  or  x p pump                   remove one.  a pump can't go while it waters a bed.
+void registryCommand() {
+  char line[64];
+  byte n = Serial.readBytesUntil('\n', line, sizeof(line) - 1);
+  line[n] = 0;
+  while ( Serial.read() > -1); // dump anything trailing.
+
+  RegistryHeader h;
+  if ( !registryBegin(h) ) {
+    Serial << F("Registry: EEPROM copy is bad.") << endl;
+    return;
+  }
+  char *text = line + 1;
+
+  if ( line[0] == 's' ) {
+    // checked before they go into bytes, which would wrap 256 to 0.  the bed keeps moisture in 4 bits.
+    unsigned long s = strtoul(text, &text, 10);
+    SensorEntry e;
+    e.code = strtoul(text, &text, 10);
+    unsigned long minMoist = strtoul(text, &text, 10);
+    unsigned long maxMoist = strtoul(text, &text, 10);
+    unsigned long p = strtoul(text, &text, 10);
+    e.minMoist = minMoist;
+    e.maxMoist = maxMoist;
+    e.pump = p;
+    if ( s > h.nSensors || s >= MAX_SENSORS || maxMoist > 15 || minMoist > maxMoist || p >= h.nPumps ||
+         !registryName(e.name, text) ) {
+      Serial << F("Registry: s bed code minMoist maxMoist pump name. Beds 0-") << min(h.nSensors, MAX_SENSORS - 1);
+      Serial << F(", moisture 0-15 with min <= max, pumps 0-") << h.nPumps - 1 << F(".") << endl;
+      return;
+    }
+    registryPut(s, e);
+    if ( s == h.nSensors ) h.nSensors++;
+    registryPutHeader(h);
+    registrySeal();
+    registrySensor(h, s);
+
+  } else if ( line[0] == 'p' ) {
+    unsigned long p = strtoul(text, &text, 10);
+    if ( p > h.nPumps || p >= MAX_PUMPS ) {
+      Serial << F("Registry: p pump onCode offCode pulsed name. Pumps 0-") << min(h.nPumps, MAX_PUMPS - 1) << F(".") << endl;
+      return;
+    }
+    PumpEntry e;
+    if ( p < h.nPumps ) {
+      registryGet(p, e);
+    } else {
+      // new pumps get the usual pulse/soak settings
+      e.pulseSec = 60;
+      e.soakMin = 10;
+      e.minPulseSec = 20;
+      e.maxPulseSec = 300;
+    }
+    e.onCode = strtoul(text, &text, 10);
+    e.offCode = strtoul(text, &text, 10);
+    e.pulsed = strtoul(text, &text, 10) != 0;
+    if ( !registryName(e.name, text) ) {
+      Serial << F("Registry: p pump onCode offCode pulsed name.") << endl;
+      return;
+    }
+    if ( p < nPumps && pump[p].on() ) radio.txMessage(pump[p].turnOff());
+    registryPut(p, e);
+    if ( p == h.nPumps ) h.nPumps++;
+    registryPutHeader(h);
+    registrySeal();
+    registryPump(h, p);
+
+  } else if ( line[0] == 'x' ) {
+    while ( *text == ' ' ) text++;
+    char what = *text++;
+    unsigned long i = strtoul(text, &text, 10);
+    if ( what == 's' && i < h.nSensors ) {
+      for ( byte s = i; s + 1 < h.nSensors; s++ ) {
+        SensorEntry e;
+        registryGet(s + 1, e);
+        registryPut(s, e);
+        sensor[s] = sensor[s + 1];
+        sensor[s].setSlot(s);
+        ps[s] = ps[s + 1];
+      }
+      nSensors = --h.nSensors;
+    } else if ( what == 'p' && i < h.nPumps ) {
+      for ( byte s = 0; s < h.nSensors; s++ ) {
+        if ( ps[s] == i ) {
+          char name[REGISTRY_NAME];
+          sensor[s].getName(name);
+          Serial << F("Registry: pump ") << i << F(" waters ") << name << F(". Move that bed first.") << endl;
+          return;
+        }
+      }
+      if ( pump[i].on() ) radio.txMessage(pump[i].turnOff());
+      for ( byte p = i; p + 1 < h.nPumps; p++ ) {
+        PumpEntry e;
+        registryGet(p + 1, e);
+        registryPut(p, e);
+        pump[p] = pump[p + 1];
+        pump[p].setSlot(p);
+        pulsed[p] = pulsed[p + 1];
+        pulse[p] = pulse[p + 1];
+      }
+      nPumps = --h.nPumps;
+      for ( byte s = 0; s < h.nSensors; s++ ) {
+        if ( ps[s] > i ) {
+          SensorEntry e;
+          registryGet(s, e);
+          e.pump = --ps[s];
+          registryPut(s, e);
+        }
+      }
+    } else {
+      Serial << F("Registry: x s bed, or x p pump.") << endl;
+      return;
+    }
+    registryPutHeader(h);
+    registrySeal();
+  }
+
+  registryPrint(h);
+}
+
 void printSensors() {
   for ( int s = 0; s < nSensors; s++ ) sensor[s].print();
 }
 
 void pumpsAllOff() {
   Serial << F("Shutting down all pumps...") << endl;
-  for (int p = 0; p < nPumps; p++ ) {
-    radio.txMessage(pump[p].turnOff());
-    delay(1000);
-  }
+  for (int p = 0; p < nPumps; p++ ) radio.txMessage(pump[p].turnOff());
 }
 
 void printTime() {
-  static bool h12 = false;
-  static bool PM = false;
-  static bool Century = false;
+  // a burst read when the second is due to turn over; every reading in between works from millis()
+  DS3231Snapshot t;
+  rtc.getCachedTime(t);
+
+  Serial << t.hour << F(":") << t.minute << F(":") << t.second << F(" ");
+  Serial << t.month << F("/") << t.date << F("/") << t.year;
+}
+
+void logClock() {
+  DS3231Snapshot t;
+  rtc.getCachedTime(t);
 
-  Serial << rtc.getHour(h12, PM) << F(":") << rtc.getMinute() << F(":") << rtc.getSecond() << F(" ");
-  Serial << rtc.getMonth(Century) << F("/") << rtc.getDate() << F("/") << rtc.getYear();
+  Log.event(LOG_CLOCK) << t.hour << t.minute << t.second << t.month << t.date << t.year;
 }
 
-// some morse code to indicate what we're doing
+// some morse code to indicate what we're doing.  each one plays unless another is already playing.
 void ledTooDry() {
-  ledMorse('d');
-  ledMorse('.');
+  ledPlay("d.");
 }
 
 void ledWatering() {
-  ledMorse('w');
-  ledMorse('.');
+  ledPlay("w.");
 }
 
 void ledSOS() {
-  ledMorse('s');
-  ledMorse('o');
-  ledMorse('s');
-  ledMorse('.');
+  ledPlay("sos.");
 }
 
-void ledMorse(char letter) {
-  const int dot = 200;
-  const int dash = 3 * dot;
-  const int pauseSpace = dot;
-  const int letterSpace = dash;
-  const int wordSpace = 7 * dot;
+// start playing word: letters, and '.' for the space at the end of a word
+void ledPlay(const char *word) {
+  if ( ledBusy() ) return;
+  ledWord = word;
+  ledCode = "";
+  ledAt = millis();
+  ledFor = 0;
+}
+
+boolean ledBusy() {
+  return( ledWord != 0 );
+}
 
+// dots and dashes for a letter, or 0 if we don't know it
+const char *ledMorse(char letter) {
   switch (letter) {
-    case 's':  // "S".  three dots.
-      for (int i = 0; i < 3; i++) {
-        digitalWrite(LED, HIGH);
-        delay(dot);
-        digitalWrite(LED, LOW);
-        delay(pauseSpace);
-      }
-      delay(letterSpace);
-      break;
-    case 'o': // "O".  three dashes.
-      for (int i = 0; i < 3; i++) {
-        digitalWrite(LED, HIGH);
-        delay(dash);
-        digitalWrite(LED, LOW);
-        delay(pauseSpace);
-      }
-      delay(letterSpace);
-
-      break;
-    case 'w': // "W".  dot dash dash
-      digitalWrite(LED, HIGH);
-      delay(dot);
-      digitalWrite(LED, LOW);
-      delay(pauseSpace);
-      for (int i = 0; i < 2; i++) {
-        digitalWrite(LED, HIGH);
-        delay(dash);
-        digitalWrite(LED, LOW);
-        delay(pauseSpace);
-      }
-      delay(letterSpace);
-
-      break;
-    case 'd': // "D".  dash dot dot
-      digitalWrite(LED, HIGH);
-      delay(dash);
-      digitalWrite(LED, LOW);
-      delay(pauseSpace);
-      for (int i = 0; i < 2; i++) {
-        digitalWrite(LED, HIGH);
-        delay(dot);
-        digitalWrite(LED, LOW);
-        delay(pauseSpace);
-      }
-      delay(letterSpace);
-
-      break;
-    case '.': // end of word
-      delay(wordSpace);
-      break;
-    default:
-      Serial << F("Don't know morse for: ") << letter << endl;
-      break;
+    case 's': return( "..." );
+    case 'o': return( "---" );
+    case 'w': return( ".--" );
+    case 'd': return( "-.." );
+    default: return( 0 );
+  }
+}
+
+// one step: light for a dot or a dash, dark for the space after it (a letter's or a word's)
+void ledUpdate() {
+  const unsigned int dot = 200;
+  const unsigned int dash = 3 * dot;
+  const unsigned int pauseSpace = dot;
+  const unsigned int letterSpace = dash;
+  const unsigned int wordSpace = 7 * dot;
+
+  if ( !ledBusy() || millis() - ledAt < ledFor ) return;
+  ledAt = millis();
+
+  if ( ledLit ) {
+    digitalWrite(LED, LOW);
+    ledLit = false;
+    ledFor = pauseSpace;
+    if ( *ledCode == 0 ) ledFor += letterSpace;
+    return;
+  }
+  if ( *ledCode ) {
+    digitalWrite(LED, HIGH);
+    ledLit = true;
+    ledFor = ( *ledCode++ == '-' ) ? dash : dot;
+    return;
+  }
+
+  // next letter
+  char letter = *ledWord;
+  if ( letter == 0 ) {
+    ledWord = 0;
+    return;
+  }
+  ledWord++;
+  ledFor = 0;
+  if ( letter == '.' ) {
+    ledFor = wordSpace;
+    return;
+  }
+  ledCode = ledMorse(letter);
+  if ( ledCode == 0 ) {
+    Serial << F("Don't know morse for: ") << letter << endl;
+    ledCode = "";
   }
 }
 
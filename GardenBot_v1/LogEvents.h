@@ -0,0 +1,29 @@
+/*
+
+Binary log events (see BinLog.h).  Each entry is an id and the format a host
+decoder expands its record with; the conversions give the size of each argument
+in the order it is streamed.  Append new events at the end: the ids are the
+positions in this list.
+
+*/
+
+#ifndef LogEvents_h
+#define LogEvents_h
+
+#include <BinLog.h> // this needs to be #include'd in the .ino file, too.
+
+#define LOG_EVENTS(X) \
+  X(LOG_CLOCK,    "RTC: %b:%b:%b %b/%b/%b") \
+  X(LOG_SENSOR,   "%s. Moisture curr[min/max]: %b[%b/%b]. Temp: %fF.") \
+  X(LOG_OUTLET,   "%s. Status (1=ON): %b.") \
+  X(LOG_RADIO,    "Radio: rxPin %d, txPin %d") \
+  X(LOG_PROTOCOL, "Protocol %b pulseLength %u us, %b bits. Sync %u/%u us, Zero %u/%u us, One %u/%u us (HIGH/LOW)") \
+  X(LOG_PUMP_RUN, "%s ran %lu s. Pulse now %u s.") \
+  X(LOG_FRAME,    "Radio: unknown receipt. Protocol: %d Bit Length: %d Message: %lu") \
+  X(LOG_ALARM,    "Watering alarm.") \
+  X(LOG_LINK,     "Radio: protocol %b syncs %u frames %u busy %u repeats %u bad HIGH %u bad LOW %u unit %u us") \
+  X(LOG_NOISE,    "Radio: noise edges %lu")
+
+enum { LOG_EVENTS(BINLOG_ENUM) LOG_NEVENTS };
+
+#endif
@@ -1,56 +1,69 @@
 #include "Radio.h"
+#include "LogEvents.h"
 
-// TB304BC = 0, ETEK = 1
-
-// bitstream length for each protocol.
-const int messageLength[NPROT] = { 32, 24 };
-
-// HIGH pulse duration, in us.
-const unsigned long pulseLength[NPROT] = { 475UL, 180UL };
-
-// to transmit a "one", Tx HIGH for duration A, then Tx LOW for duration B.
-// units are multiples of pulseLength.
-// for example {3,1} means: Tx HIGH for 3*pulseLength, Tx LOW for 1*pulseLength
-const unsigned long oneSeq[NPROT][2] = {
-  { 1, 4000UL / pulseLength[0] }, // TB304BC
-  { 3, 1 } // ETEK
-};
-// to transmit a "zero", Tx HIGH for duration A, then Tx LOW for duration B.
-// units are multiple of pulseLength
-// for example {1,3} means: Tx HIGH for 1*pulseLength, Tx LOW for 3*pulseLength
-const unsigned long zeroSeq[NPROT][2] = {
-  { 1, 2000UL / pulseLength[0] }, // TB304BC
-  { 1, 3 } // ETEK
-};
-// at the start of a bistream/message, send a preamble, following a similar pattern as above
-// units are multiples of pulseLength
-const unsigned long syncSeq[NPROT][2] = {
-  { 1, 9000UL / pulseLength[0] }, // TB304BC
-  { 1, 31 } // ETEK
-};
+// TB304BC = 0, ETEK = 1.  see RadioRx.h for the timings.
+const RadioProtocol protocol[NPROT] = { RADIO_TB304BC, RADIO_ETEK };
+
+// the receiver, and its state for each protocol
+RadioChannel channel[NPROT];
+RadioRx rx;
 
 // ISR's can't be class member functions unless static.  PITA.
 // so, we use some globals as glue between the class and the ISR.
-volatile boolean ISR_rxReady;
 volatile int ISR_rxPin;
-volatile int ISR_rxProt;
-volatile unsigned long ISR_rxVal;
+
+#if RADIO_SNIFF_EDGES > 0
+// learning mode capture.  the ISR only writes while ISR_sniff is SNIFF_WAIT or SNIFF_REC.
+#define SNIFF_OFF 0
+#define SNIFF_WAIT 1  // for a gap
+#define SNIFF_REC 2   // recording since one
+#define SNIFF_DONE 3  // a capture is waiting for sniffNext()
+volatile byte ISR_sniff = SNIFF_OFF;
+volatile byte ISR_sniffN;
+volatile unsigned int ISR_sniffEdges[RADIO_SNIFF_EDGES];
+
+static inline void sniffEdge(unsigned long deltaTime, byte pinVal) {
+  unsigned int e = deltaTime > 65535UL ? 65535U : deltaTime;
+  // a long LOW just ended: a frame starts, or ends
+  boolean gap = pinVal == HIGH && deltaTime >= RADIO_SNIFF_GAP;
+  if ( ISR_sniff == SNIFF_WAIT ) {
+    if ( gap ) {
+      ISR_sniffEdges[0] = e;
+      ISR_sniffN = 1;
+      ISR_sniff = SNIFF_REC;
+    }
+  } else if ( ISR_sniff == SNIFF_REC ) {
+    ISR_sniffEdges[ISR_sniffN++] = e;
+    if ( gap && ISR_sniffN >= RADIO_SNIFF_MIN ) {
+      ISR_sniff = SNIFF_DONE;
+    } else if ( gap ) {
+      // too short for a frame.  this gap may start one, though.
+      ISR_sniffEdges[0] = e;
+      ISR_sniffN = 1;
+    } else if ( ISR_sniffN >= RADIO_SNIFF_EDGES ) {
+      // too long
+      ISR_sniff = SNIFF_WAIT;
+    }
+  }
+}
+#endif
 
 // valid rxPins found in http://arduino.cc/en/Reference/attachInterrupt
 // for Uno: D2,D3
 void Radio::begin(int rxPin, int txPin) {
   Serial << F("Radio: startup.") << endl;
 
+  // the decoders, before the ISR can run
+  rx.begin(protocol, channel, NPROT);
+
   // assign rxPin
   switch (rxPin) {
     case 2:
-      Serial << F("Radio: rxPin 2, int.0") << endl;
       ISR_rxPin = 2;
       pinMode(ISR_rxPin, INPUT);
       attachInterrupt(0, interruptHandler, CHANGE); // D2 is int.0
       break;
     case 3:
-      Serial << F("Radio: rxPin 3, int.1") << endl;
       ISR_rxPin = 3;
       pinMode(ISR_rxPin, INPUT);
       attachInterrupt(1, interruptHandler, CHANGE); // D3 is int.1
@@ -65,16 +78,15 @@ void Radio::begin(int rxPin, int txPin) {
   this->txPin = txPin;
   pinMode(this->txPin, OUTPUT);
   digitalWrite(this->txPin, LOW);
-  Serial << F("Radio. txPin ") << this->txPin << endl;
-
-  // show the timings that we understand
-  Serial << F("Protocol information:") << endl;
-  for (int p = 0; p < NPROT; p++) {
-    Serial << F("Protocol ") << p << F(" pulseLength ") << pulseLength[p] << F(" us.  Message bit length ") << messageLength[p] << F(".") << endl;
-    Serial << F("Protocol ") << p << F(" Sync: HIGH ") << pulseLength[p]*syncSeq[p][0] << F(" us, LOW ") << pulseLength[p]*syncSeq[p][1] << F(" us.") << endl;
-    Serial << F("Protocol ") << p << F(" Zero: HIGH ") << pulseLength[p]*zeroSeq[p][0] << F(" us, LOW ") << pulseLength[p]*zeroSeq[p][1] << F(" us.") << endl;
-    Serial << F("Protocol ") << p << F("  One: HIGH ") << pulseLength[p]*oneSeq[p][0] << F(" us, LOW ") << pulseLength[p]*oneSeq[p][1] << F(" us.") << endl;
-    Serial << endl;
+  Log.event(LOG_RADIO) << rxPin << this->txPin;
+
+  // log the timings that we understand.  all under 65 ms, so they go as unsigned ints
+  for (byte p = 0; p < NPROT; p++) {
+    const RadioProtocol &r = protocol[p];
+    Log.event(LOG_PROTOCOL) << p << r.pulseLength << r.bits
+      << r.pulseLength * r.sync[0] << r.pulseLength * r.sync[1]
+      << r.pulseLength * r.zero[0] << r.pulseLength * r.zero[1]
+      << r.pulseLength * r.one[0] << r.pulseLength * r.one[1];
   }
   
   // set some defaults
@@ -82,7 +94,7 @@ void Radio::begin(int rxPin, int txPin) {
   this->txProtocol(0);
   
   // clear rx buffer
-  this->rxClear();
+  rx.clear();
 
   Serial << F("Radio: startup complete.") << endl;
 }
@@ -90,36 +102,95 @@ void Radio::begin(int rxPin, int txPin) {
 // receiving functions
 
 // is there a message available?
+// frames of different protocols wait side by side; this picks one, and the calls below are about
+// that one until it's rxClear()ed, whatever else arrives meanwhile.
 boolean Radio::rxAvailable() {
-  return ( ISR_rxReady );
+  return ( rx.available() );
 }
 
 // if there is a message, what protocol was is received under?
 int Radio::rxProtocol() {
-  if ( ISR_rxReady ) return ( ISR_rxProt );
-  else return ( -1 );
+  return ( rx.protocol() );
 }
 
 // if there is a message, what is the bit length for the protocol is was received under?
 int Radio::rxBitLength() {
-  if ( ISR_rxReady ) return ( messageLength[ISR_rxProt] );
+  if ( rx.available() ) return ( rx.bits() );
   else return ( -1 );
 }
 
 // if there is a message, return the value.  Limited to 32 bits.
 unsigned long Radio::rxMessage() {
-  if ( ISR_rxReady ) return ( ISR_rxVal );
-  else return ( 0 );
+  return ( rx.message() );
 }
 
-// if there's a message available, no new messages will be received until this is called.
+// if there's a message available, no new messages of its protocol will be received until this is called.
+// with none picked by rxAvailable() yet, clears them all.
 void Radio::rxClear() {
-  ISR_rxProt = -1;
-  ISR_rxVal = 0;
-  ISR_rxReady = false;
+  rx.clear();
 }
 
 
+// link quality
+void Radio::getStats(int prot, RadioStats &stats) {
+  rx.getStats(prot, stats);
+}
+
+unsigned long Radio::getNoise() {
+  return ( rx.getNoise() );
+}
+
+void Radio::clearStats() {
+  rx.clearStats();
+}
+
+void Radio::printStats() {
+  for (int p = 0; p < NPROT; p++) {
+    RadioStats st;
+    getStats(p, st);
+    Serial << F("Radio: protocol ") << p << F(" syncs ") << st.syncs << F(" frames ") << st.frames;
+    Serial << F(" busy ") << st.busy << F(" repeats ") << st.repeats;
+    Serial << F(" bad HIGH ") << st.badHigh << F(" bad LOW ") << st.badLow;
+    Serial << F(" unit ") << getUnit(p) << F(" us") << endl;
+  }
+  Serial << F("Radio: noise edges ") << getNoise() << endl;
+}
+
+unsigned int Radio::getUnit(int prot) {
+  return ( rx.getUnit(prot) );
+}
+
+void Radio::sniff(boolean on) {
+#if RADIO_SNIFF_EDGES > 0
+  ISR_sniff = on ? SNIFF_WAIT : SNIFF_OFF;
+#endif
+}
+
+boolean Radio::sniffing() {
+#if RADIO_SNIFF_EDGES > 0
+  return ( ISR_sniff != SNIFF_OFF );
+#else
+  return ( false );
+#endif
+}
+
+byte Radio::sniffCapture(const unsigned int *&edges) {
+#if RADIO_SNIFF_EDGES > 0
+  if ( ISR_sniff != SNIFF_DONE ) return ( 0 );
+  // the ISR leaves it alone until sniffNext()
+  edges = (const unsigned int *)ISR_sniffEdges;
+  return ( ISR_sniffN );
+#else
+  return ( 0 );
+#endif
+}
+
+void Radio::sniffNext() {
+#if RADIO_SNIFF_EDGES > 0
+  if ( ISR_sniff == SNIFF_DONE ) ISR_sniff = SNIFF_WAIT;
+#endif
+}
+
 // transmission functions
 // set tx protocol
 void Radio::txProtocol(int prot) {
@@ -160,13 +231,13 @@ void Radio::txNoise(int n) {
 
 // send a message
 void Radio::sendValue(int prot, unsigned long val) {  
-//  Serial << F("sendValue: prot=") << prot << F(" value=") << val << F(" bitLength=") << messageLength[prot] << endl;
+//  Serial << F("sendValue: prot=") << prot << F(" value=") << val << F(" bitLength=") << protocol[prot].bits << endl;
   // send sync
-  sendSeq(prot, syncSeq);
+  sendSeq(prot, protocol[prot].sync);
   // send MSB first
-  for (int b = messageLength[prot] - 1; b >= 0; b-- ) {
-    if ( bitRead(val, b) == 1 ) sendSeq(prot, oneSeq);
-    else sendSeq(prot, zeroSeq);
+  for (int b = protocol[prot].bits - 1; b >= 0; b-- ) {
+    if ( bitRead(val, b) == 1 ) sendSeq(prot, protocol[prot].one);
+    else sendSeq(prot, protocol[prot].zero);
   }
   // toggle pin complete Tx
   digitalWrite(this->txPin, HIGH);
@@ -174,10 +245,10 @@ void Radio::sendValue(int prot, unsigned long val) {
 }
 
 // Tx a sync, zero, and one sequence
-void Radio::sendSeq(int prot, const unsigned long seq[NPROT][2]) {
-  pinSet(HIGH, pulseLength[prot] * seq[prot][0]);
-  pinSet(LOW, pulseLength[prot] * seq[prot][1]);
-//  Serial << F("SendSeq: prot=") << prot << F(" high time=") << pulseLength[prot] * seq[prot][0] << F(" low time=") << pulseLength[prot] * seq[prot][1] << endl;
+void Radio::sendSeq(int prot, const byte seq[2]) {
+  pinSet(HIGH, (unsigned long)protocol[prot].pulseLength * seq[0]);
+  pinSet(LOW, (unsigned long)protocol[prot].pulseLength * seq[1]);
+//  Serial << F("SendSeq: prot=") << prot << F(" high time=") << protocol[prot].pulseLength * seq[0] << F(" low time=") << protocol[prot].pulseLength * seq[1] << endl;
 }
 
 // Tx helper.  BLOCKING function to hold the Tx signals HIGH and LOW for the proper intervals
@@ -188,17 +259,13 @@ void Radio::pinSet(int state, unsigned long interval) {
   // note: we don't use delayMicroseconds, as that's inaccurate with ISR's running the background.
 }
 
-// ISR.  Thar be dragons--prepare for battle.
+// ISR.  times the edge, and hands it to learning mode and the decoders.
 void interruptHandler() {
 
-  // have we gotten a valid sync signal?
-  static boolean gotSync = false;
   // last time ISR was called
   static unsigned long lastTime = micros();
   // current time; important to do this first so we don't lose time in later calcs.
   static unsigned long currTime = micros();
-  // current number of bits received since sync;
-  static byte rxCounts = 0;
   
   // set this soonest so we don't lose time from later calcs.
   currTime = micros();
@@ -209,91 +276,15 @@ void interruptHandler() {
   // update tracking
   lastTime = currTime;
 
-  // if we have a message waiting, exit
-  if ( ISR_rxReady ) return;
-
-  // track end-of-message
-  boolean eom = false;
-
   // read rxPin state, quickly
   // PIND gives the bitWise pin states for D0-D7.  
   // D2 is bit 2, D3 is bit 3
   byte currPinVal = bitRead(PIND, ISR_rxPin);
 
-  if ( currPinVal == HIGH ) {
-    // first, let's establish a sync
-    // both protocols start with a long LOW time, so we'll catch HIGH transition.
-    //Serial << F("H");
-    if ( ! gotSync ) {
-      //Serial << F("s");
-      for ( byte p = 0; p < NPROT; p++ ) {
-        if ( isWithin(deltaTime, pulseLength[p]*syncSeq[p][1], RADIO_SLOP) ) {
-          // that's a sync signal
-          gotSync = true;
-          ISR_rxProt = p; // store receiving protocol
-          ISR_rxVal = 0; // reset rxVal
-          rxCounts = 0; // reset rxCounts
-          //Serial << F("S");
-        } else {
-          //Serial << F("n");
-        }
-      }
-    } else {
-      // we have a previous sync, so decode bit stream.
-      if ( isWithin(deltaTime, pulseLength[ISR_rxProt]*oneSeq[ISR_rxProt][1], RADIO_SLOP) ) {
-        // Rx == 1
-        rxCounts++;
-        ISR_rxVal = (ISR_rxVal << 1) + 1; // bitshift current value up and add one at LSB
-        //Serial << F("1");
-
-      } else if ( isWithin(deltaTime, pulseLength[ISR_rxProt]*zeroSeq[ISR_rxProt][1], RADIO_SLOP) ) {
-        // Rx == 0
-        rxCounts++;
-        ISR_rxVal = (ISR_rxVal << 1) + 0; // bitshift current value up and add zero at LSB
-        //Serial << F("0");
-      } else {
-        // uh oh, we got nonsense.
-        eom = true;
-      }
-    }
-  } else if ( gotSync ) {
-    // so, we're got a sync, but the pin has just gone LOW
-    // let's use this time for some error checking, as we know how long the positive pulses are
-    if ( isWithin(deltaTime, pulseLength[ISR_rxProt]*oneSeq[ISR_rxProt][0], RADIO_SLOP) || // right pulse length to lead "one"
-         isWithin(deltaTime, pulseLength[ISR_rxProt]*zeroSeq[ISR_rxProt][0], RADIO_SLOP) ) { // right pulse length to lead "zero"
-      // that's good.
-    } else {
-      // uh oh, we got nonsense.
-      eom = true;
-      //Serial << F("?");
-    }
-
-    // maybe we've got enough bits?
-    if ( rxCounts >= messageLength[ISR_rxProt] ) {
-      eom = true;
-      //Serial << F("L");
-    }
-
-  }
+#if RADIO_SNIFF_EDGES > 0
+  if ( ISR_sniff ) sniffEdge(deltaTime, currPinVal);
+#endif
 
-  // we've reached the end of message, somehow
-  if ( eom ) {
-    // did we get a good message?
-    if ( rxCounts >= messageLength[ISR_rxProt] ) ISR_rxReady = true;
-    // reset sync for next time.
-    gotSync = false;
-    //Serial << F("E");
-  }
+  // the decoders, one per protocol
+  rx.edge(deltaTime, currPinVal, millis());
 }
-
-// Rx helper to allow deviation from the protocol timings
-boolean isWithin(unsigned long val, unsigned long test, byte percentOf) {
-  unsigned long upper = (test * percentOf) / 100;
-  unsigned long lower = (test * 100) / percentOf;
-//  Serial << "isWithin.  val=" << val << " test= " << test << "[" << lower << "," << upper << "]" << endl;
-  return ( val <= upper && val >= lower );
-}
-
-
-
-
@@ -1,24 +1,11 @@
 /*
 
-Radio interface module.  Knows the following protocols:
+Radio interface module.  Receiving is RadioRx's (see RadioRx.h), which every
+sketch here shares; this adds the pins, transmitting, and learning mode.
+Knows the following protocols:
 
-Thermor BIOS Wireless Moisture and Temperature Sensor (TB304BC)
-see http://rayshobby.net/reverse-engineer-a-cheap-wireless-soil-moisture-sensor/
-Encoding. Each transmission consists of 8 repetitions.
-The above shows one repetition:
-it starts with a sync signal (9000us low);
-a logic 1 is a impulse (475us) high followed by a 4000us low;
-a logic 0 is the same impulse high followed by a 2000us low.
-
-Etekcity Outlet
-
-// https://code.google.com/p/rc-switch/wiki/KnowHow_LineCoding
-
-Pulse length: 180us (1/31 time of the synchronization low level)
-Synchronization: 1 Pulse High + 31 Pulses Low
-Bits:
-0: 1 Pulse High + 3 Pulses Low
-1: 3 Pulses High + 1 Pulse Low
+0: Thermor BIOS Wireless Moisture and Temperature Sensor (TB304BC)
+1: Etekcity Outlet
 
 */
 
@@ -28,10 +15,15 @@ Bits:
 // TB304BC = 0, ETEK = 1
 #define NPROT 2
 
-#define RADIO_SLOP 150 // packet length can be this percent off from protocol spec.
+// learning mode (see RadioSniff.h) keeps the raw edges of one frame: a LOW gap at least RADIO_SNIFF_GAP
+// long, the frame, and the next such gap.  RADIO_SNIFF_EDGES 0 leaves it out, and its RAM.
+#define RADIO_SNIFF_EDGES 80
+#define RADIO_SNIFF_GAP 5000 // us
+#define RADIO_SNIFF_MIN 19 // edges in the shortest capture kept: 8 bits
 
 #include <Arduino.h>
 #include <Streaming.h> // this needs to be #include'd in the .ino file, too.
+#include <RadioRx.h> // this needs to be #include'd in the .ino file, too.
 
 class Radio {
   public:
@@ -48,9 +40,29 @@ class Radio {
     int rxBitLength();
     // if there is a message, return the value.  Limited to 32 bits.
     unsigned long rxMessage();
-    // if there's a message available, no new messages will be received until this is called.
+    // if there's a message available, no new messages of its protocol will be received until this is called.
     void rxClear();
 
+    // link quality
+    // counters for protocol prot since the last clearStats()
+    void getStats(int prot, RadioStats &stats);
+    // edges that weren't part of a frame or a sync: a busy band, or a receiver hearing only noise
+    unsigned long getNoise();
+    void clearStats();
+    // show the counters
+    void printStats();
+    // pulse length learned for protocol prot, in us
+    unsigned int getUnit(int prot);
+
+    // learning mode: capture raw frames of any protocol, alongside the decoding
+    void sniff(boolean on);
+    boolean sniffing();
+    // if a frame has been captured, point edges at its times (us; LOW gap, HIGH, LOW, ..., LOW gap)
+    // and return how many.  it stays put until sniffNext().
+    byte sniffCapture(const unsigned int *&edges);
+    // done with the capture; look for the next one
+    void sniffNext();
+
     // transmission functions
     // set tx protocol
     void txProtocol(int prot);
@@ -74,8 +86,8 @@ class Radio {
     // low-level functionality
     // send a message
     void sendValue(int prot, unsigned long val);
-    // Tx a sync, zero, and one sequence
-    void sendSeq(int prot, const unsigned long seq[NPROT][2]);
+    // Tx a sync, zero, or one sequence
+    void sendSeq(int prot, const byte seq[2]);
     // Tx helper.  BLOCKING function to hold the Tx signals HIGH and LOW for the proper intervals
     void pinSet(int state, unsigned long interval);
 };
@@ -83,7 +95,5 @@ class Radio {
 
 // ISR for Rx.  Can't attach interrupt to a class member function directly.
 void interruptHandler();
-// Rx helper to allow deviation from the protocol timings
-boolean isWithin(unsigned long val, unsigned long test, byte percentOf);
 
 #endif
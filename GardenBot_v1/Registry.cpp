@@ -0,0 +1,114 @@
+#include <stddef.h>
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+#include "Registry.h"
+
+#define SENSOR_ADDR(i) (REGISTRY_ADDR + sizeof(RegistryHeader) + (i) * sizeof(SensorEntry))
+#define PUMP_ADDR(i) (SENSOR_ADDR(MAX_SENSORS) + (i) * sizeof(PumpEntry))
+#define CRC_ADDR PUMP_ADDR(MAX_PUMPS)
+
+// CRC of n bytes of EEPROM from REGISTRY_ADDR, a block at a time
+static unsigned int crc(unsigned int n) {
+  byte buf[16];
+  unsigned int c = 0xFFFF;
+  for (unsigned int at = 0; at < n; at += sizeof(buf)) {
+    byte k = min(n - at, sizeof(buf));
+    eeprom_read_block(buf, (const void *)(REGISTRY_ADDR + at), k);
+    for (byte i = 0; i < k; i++) c = _crc16_update(c, buf[i]);
+  }
+  return ( c );
+}
+
+// move n entries of one kind from an old layout to ours, leaving new fields 0.  when they move up,
+// by the block moving or the entries growing, that's done from the last one down, so none is
+// overwritten before it's read.
+static void move(unsigned int from, byte fromSize, unsigned int to, byte toSize, byte n) {
+  byte buf[max(sizeof(SensorEntry), sizeof(PumpEntry))];
+  for (byte k = 0; k < n; k++) {
+    byte i = to > from || toSize > fromSize ? n - 1 - k : k;
+    memset(buf, 0, toSize);
+    eeprom_read_block(buf, (const void *)(from + i * fromSize), min(fromSize, toSize));
+    eeprom_update_block(buf, (void *)(to + i * toSize), toSize);
+  }
+}
+
+boolean registryBegin(RegistryHeader &h) {
+  eeprom_read_block(&h, (const void *)REGISTRY_ADDR, sizeof(h));
+  if ( h.magic != REGISTRY_MAGIC ) return ( false );
+
+  unsigned int sensors = REGISTRY_ADDR + sizeof(h);
+  unsigned int pumps = sensors + h.maxSensors * h.sensorSize;
+  unsigned int n = pumps + h.maxPumps * h.pumpSize - REGISTRY_ADDR;
+  if ( REGISTRY_ADDR + n + 2 > E2END + 1 ) return ( false );
+  if ( crc(n) != eeprom_read_word((const uint16_t *)(REGISTRY_ADDR + n)) ) return ( false );
+  if ( h.nSensors > MAX_SENSORS || h.nPumps > MAX_PUMPS ) return ( false );
+  // every bed's pump has to be there.  a layout without the field reads it as 0.
+  for (byte i = 0; i < h.nSensors; i++) {
+    byte pump = 0;
+    if ( h.sensorSize > offsetof(SensorEntry, pump) ) {
+      pump = eeprom_read_byte((const uint8_t *)(sensors + i * h.sensorSize + offsetof(SensorEntry, pump)));
+    }
+    if ( pump >= h.nPumps ) return ( false );
+  }
+
+  if ( h.sensorSize != sizeof(SensorEntry) || h.pumpSize != sizeof(PumpEntry) ||
+       h.maxSensors != MAX_SENSORS || h.maxPumps != MAX_PUMPS ) {
+    // another sketch's layout.  only growing ones can be moved in place.
+    if ( h.sensorSize > sizeof(SensorEntry) || h.pumpSize > sizeof(PumpEntry) || pumps > PUMP_ADDR(0) ) return ( false );
+    move(pumps, h.pumpSize, PUMP_ADDR(0), sizeof(PumpEntry), h.nPumps);
+    move(sensors, h.sensorSize, SENSOR_ADDR(0), sizeof(SensorEntry), h.nSensors);
+    registryPutHeader(h);
+    registrySeal();
+  }
+  return ( true );
+}
+
+void registryFormat(RegistryHeader &h) {
+  h.nSensors = h.nPumps = 0;
+  registryPutHeader(h);
+  registrySeal();
+}
+
+void registryGet(byte i, SensorEntry &e) {
+  eeprom_read_block(&e, (const void *)SENSOR_ADDR(i), sizeof(e));
+  e.name[REGISTRY_NAME - 1] = 0;
+}
+
+void registryGet(byte i, PumpEntry &e) {
+  eeprom_read_block(&e, (const void *)PUMP_ADDR(i), sizeof(e));
+  e.name[REGISTRY_NAME - 1] = 0;
+}
+
+void registrySensorName(byte i, char *name) {
+  eeprom_read_block(name, (const void *)SENSOR_ADDR(i), REGISTRY_NAME);
+  name[REGISTRY_NAME - 1] = 0;
+}
+
+void registryPumpName(byte i, char *name) {
+  eeprom_read_block(name, (const void *)PUMP_ADDR(i), REGISTRY_NAME);
+  name[REGISTRY_NAME - 1] = 0;
+}
+
+// update, not write: unchanged bytes cost no time and no wear
+void registryPut(byte i, const SensorEntry &e) {
+  eeprom_update_block(&e, (void *)SENSOR_ADDR(i), sizeof(e));
+}
+
+void registryPut(byte i, const PumpEntry &e) {
+  eeprom_update_block(&e, (void *)PUMP_ADDR(i), sizeof(e));
+}
+
+void registryPutHeader(const RegistryHeader &h) {
+  RegistryHeader ours = h;
+  ours.magic = REGISTRY_MAGIC;
+  ours.version = REGISTRY_VERSION;
+  ours.sensorSize = sizeof(SensorEntry);
+  ours.pumpSize = sizeof(PumpEntry);
+  ours.maxSensors = MAX_SENSORS;
+  ours.maxPumps = MAX_PUMPS;
+  eeprom_update_block(&ours, (void *)REGISTRY_ADDR, sizeof(ours));
+}
+
+void registrySeal() {
+  eeprom_update_word((uint16_t *)CRC_ADDR, crc(CRC_ADDR - REGISTRY_ADDR));
+}
@@ -0,0 +1,74 @@
+/*
+
+Device registry.  The beds' sensors and the pumps' outlets, with the pump that
+waters each bed, kept in the ATmega's EEPROM so they can be changed over the
+serial port (see getTimeUpdate()) without reflashing, and without losing
+the other beds' state.  The names stay here too, and are read when printed,
+so they cost no RAM.
+
+Layout at REGISTRY_ADDR: a header, MAX_SENSORS SensorEntry, MAX_PUMPS
+PumpEntry, then a CRC-16 of all of it.  The header carries the schema version,
+and the size and number of entries as stored.  Entries only ever grow at the
+end, and the header never changes, so an image written by an older sketch
+still loads: registryBegin() moves it into this layout, copying the fields
+both know and leaving the rest 0 (so a new field's 0 should mean the old
+behaviour).
+
+The table is too big for RAM at MAX_SENSORS 32, so entries are read and
+written one at a time.  After writing, registrySeal() updates the CRC.
+
+*/
+
+#ifndef Registry_h
+#define Registry_h
+
+#include <Arduino.h>
+
+#define REGISTRY_ADDR 0          // EEPROM offset
+#define REGISTRY_MAGIC 0x4247    // "GB"
+#define REGISTRY_VERSION 2
+#define REGISTRY_NAME 16         // name length, with the terminating 0
+#define MAX_SENSORS 32           // 6 bits in BIOSDigitalSoilMeter
+#define MAX_PUMPS 4
+
+typedef struct {
+  char name[REGISTRY_NAME];
+  unsigned long code;            // a message from the sensor: its address bits
+  byte minMoist, maxMoist;
+  byte pump;                     // the pump that waters this bed
+} __attribute__((packed)) SensorEntry;
+
+typedef struct {
+  char name[REGISTRY_NAME];
+  unsigned long onCode, offCode;
+  byte pulsed;                   // waters in pulses with soaks between (PulseSoak)
+  unsigned int pulseSec, soakMin, minPulseSec, maxPulseSec;
+} __attribute__((packed)) PumpEntry;
+
+typedef struct {
+  unsigned int magic;
+  byte version;
+  byte sensorSize, pumpSize;     // sizeof the entries, as stored
+  byte maxSensors, maxPumps;     // room for this many, as stored
+  byte nSensors, nPumps;         // in use
+} __attribute__((packed)) RegistryHeader;
+
+// check the table and read its header.  false if there's no good one: blank, a bad CRC,
+// a layout that can't be moved into this one, or a bed watered by a pump that isn't there.
+boolean registryBegin(RegistryHeader &h);
+// start an empty table
+void registryFormat(RegistryHeader &h);
+
+void registryGet(byte i, SensorEntry &e);
+void registryGet(byte i, PumpEntry &e);
+// just the name; REGISTRY_NAME bytes
+void registrySensorName(byte i, char *name);
+void registryPumpName(byte i, char *name);
+
+// write entries, only the bytes that changed, then seal
+void registryPut(byte i, const SensorEntry &e);
+void registryPut(byte i, const PumpEntry &e);
+void registryPutHeader(const RegistryHeader &h);
+void registrySeal();
+
+#endif
@@ -38,15 +38,16 @@ bool previous = 0;
 #include <Wire.h>
 #include <TSL2561.h>
 TSL2561 tsl(TSL2561_ADDR_FLOAT);
-uint16_t ir, full, visible, luxOld, luxNew, lum;
+uint16_t ir, full, visible, lum;
+//lux can run past 65535 in direct sun
+uint32_t luxNew;
 //set target light level here
 uint16_t luxGoal = 250;
 //set target light proportion here
 float lightProportionGoal = .7;
 float lightProportion = 0;
-//indicates current status of light. ? todo switch to just reading if relay pin is high or low?
-bool lightOn = 0;
 //mimimum and maximum amounts of time for light to turn on in seconds. only used if lightCycle = 1
+//(the minimum also applies to time off between runs)
 bool lightCycle = 0;
 int minLightCycleTime = 5;
 int maxLightCycleTime = 600;
@@ -54,25 +55,19 @@ int maxLightCycleTime = 600;
 bool lightDaily = 0;
 int minLightsDaily = 0;
 int maxLightsDaily = 10;
-//times light has been on today
-int lightsToday = 0;
-//seconds light is on
-float timeLightOn = 0;
-//seconds during which light level is at or above minimum lux
-float timeBrightEnough = 0;
-//number of seconds between turning lights off (makes sure we don't keep our assisted lighting on when it's bright enough naturally for the plants)
-int lightCheckFrequency = 1200;
+//at or above luxGoal as of the last relay check
+bool brightEnough = 0;
 
 //temp, humidity sensor
 #include <DHT.h>
 #define DHTPIN 11
 #define DHTTYPE DHT22
 DHT dht(DHTPIN, DHTTYPE);
-float humidOld, humidNew, tempOld, tempNew;
+float humidNew, tempNew;
 
 //moisture probes
 int moisturePin = 3;
-int moistOld = 0, moistNew = 0;
+int moistNew = 0;
 //set target moisture level here
 int moistGoal = 200;
 bool pumpOn = 0;
@@ -86,18 +81,83 @@ int minPumpsDaily = 0;
 int maxPumpsDaily = 10;
 //number of times pump has run today
 int pumpsToday = 0;
-//seconds pump is on
-long timePumpOn = 0;
-//total time elapsed
-float timeTotal = 0;
-float timeNew = 0;
-float timeOld = 0;
+//pump runs a slow pwm: on for the first part of each window, off for the rest. the pid picks how much,
+//from smoothed moisture against moistGoal, and each output it computes starts a window. on or off
+//stretches shorter than minPumpCycleTime are dropped to protect the pump. tools/pumpsim runs this
+//against the old bang-bang on a soil model
+#include <PID_v1.h>
+#define PUMP_WINDOW 30000 //ms. also the pid sample time, which is an int
+double moistInput, moistSetpoint, pumpOnTime;
+//output is seconds of pump per window; error is in moisture counts. tuned against a soil model with a
+//~100 s soak-in lag, so the derivative term brakes before the probe catches up. adjust for the bed
+PID moistPID(&moistInput, &pumpOnTime, &moistSetpoint, 0.1, 0.0002, 10, DIRECT);
+unsigned long pumpWindowStart = 0;
+unsigned long pumpWindowOn = 0; //ms on in the current window
+//a manual run from the imp (Pp1) holds the pump on for a window from when it came in
+bool pumpManual = false;
+unsigned long pumpManualStart = 0;
+//whole seconds counted since the last dayUpdate(). each interval between relay checks is credited
+//to the state the relays and light level were in during it, so the totals are exact at the boundary.
+//each closed day goes to serial (dutyReport) and to the imp with every reading (sendData)
+struct DutyDay {
+  unsigned long total;
+  unsigned long bright;
+  unsigned long lightOn;
+  unsigned long pumpOn;
+};
+DutyDay dutyToday = {0, 0, 0, 0};
+DutyDay dutyYesterday = {0, 0, 0, 0};
+//clock reading the totals have been brought up to, once dutyStarted. a flag, not 0: with the
+//RTC unset, now() really is 0 at boot
+bool dutyStarted = false;
+unsigned long dutyLast = 0;
+//larger steps than this are the clock being set, not time passing, and aren't counted
+#define DUTY_MAX_STEP 60
 int daysLeft = 30, daysElapsed = 0;
 
 //relays
 int relayWater = 12;
 int relayLight = 13;
 
+//light zones. each zone integrates the lux its sensor sees over the day (the daily light integral, in
+//lux-hours) against a goal of luxGoal for lightProportionGoal of the day. the lamp is held off as long
+//as the daylight still to come would reach the goal, and started only when it has to run from then to
+//the end of the day to make up the rest: one long run instead of many short ones, and none at all on a
+//bright day. daylight still to come is what the same hours brought yesterday (nothing on the first
+//day, so the lamp starts early rather than late)
+#define LIGHT_MARGIN 1800 //s. start the lamp this much earlier than strictly needed
+#define LAMP_SETTLE 30    //s after a switch before the step in lux is taken as the lamp's contribution
+struct LightZone {
+  int relay;
+  uint32_t *lux;          //sensor reading for this zone
+  uint32_t lampLux;       //what the lamp adds at the sensor, learned from each switch
+  uint32_t luxHours;      //today's integral
+  uint32_t luxSeconds;    //remainder under one lux-hour
+  uint16_t daylight[24];  //lux-hours of daylight, lamp taken out, in each hour of the day. hours not
+                          //yet reached today still hold yesterday's
+  uint32_t hourSeconds;   //daylight lux-seconds so far this hour
+  byte hour;
+  bool on;
+  bool settling;          //lampLux not yet updated for the last switch
+  uint32_t luxAtSwitch;
+  unsigned long switchedAt;
+  int runsToday;
+};
+//one sensor, one lamp on this board. more zones need their own relay and lux reading
+LightZone zones[] = {
+  //lampLux starts as a guess and is corrected at the first switch
+  {relayLight, &luxNew, 250},
+};
+#define NZONES (sizeof(zones) / sizeof(zones[0]))
+//start of the current day, for the time left in it
+unsigned long dayStart = 0;
+
+//sensor smoothing. the *New values above are the averages; display, relays and imp all read those
+#include <SensorStats.h>
+SensorStats luxStats, moistStats(3);
+//temperature and humidity kept in tenths
+SensorStats tempStats, humidStats;
+
 //imp 
 #include <SoftwareSerial.h>
 SoftwareSerial softSerial(14,15); //rx, tx
@@ -133,9 +193,10 @@ void setup()
   attachInterrupt(0, updateEncoder, CHANGE);
   attachInterrupt(1, updateEncoder, CHANGE);
   
-  //light
+  //light. start at 16x gain, 13ms integration and let auto-range pick from there
   tsl.setGain(TSL2561_GAIN_16X);
   tsl.setTiming(TSL2561_INTEGRATIONTIME_13MS);
+  tsl.setAutoRange(true);
   
   //temp
   pinMode(DHTPIN, INPUT);
@@ -146,6 +207,14 @@ void setup()
   pinMode(relayLight, OUTPUT);
   digitalWrite(relayWater, LOW);
   digitalWrite(relayLight, LOW);
+  moistPID.SetOutputLimits(0, PUMP_WINDOW / 1000);
+  moistPID.SetSampleTime(PUMP_WINDOW);
+  //the pid takes its last input from here, so start it on a real reading: from 0, the first
+  //sample's derivative term would see a jump of the whole moisture reading
+  moist();
+  moistInput = moistNew;
+  moistSetpoint = moistGoal;
+  moistPID.SetMode(AUTOMATIC);
   
   //define how many seconds to pass between sensor, relay checks, send data, and receive settings
   int sensorCheckFrequency = 1;
@@ -160,10 +229,9 @@ void setup()
   Alarm.timerRepeat(relayCheckFrequency, relayCheck);
   //send data to server every minute
   Alarm.timerRepeat(dataSendFrequency, sendData);
-  //blink lights this frequency, to make sure we're not leaving them on when natural light is sufficient
-  Alarm.timerRepeat(lightCheckFrequency, lightCheck);
   //todo: reset daily stuff, proportions every day
   Alarm.timerRepeat(86400, dayUpdate);
+  dayStart = now();
   //serial
   Serial.begin(9600);
   softSerial.begin(2400);
@@ -173,6 +241,7 @@ void loop()
 {
   //checks state of scheduled events, as per http://answers.oreilly.com/topic/2704-how-to-create-an-arduino-alarm-that-calls-a-function/ 
   Alarm.delay(1);
+  pumpCheck();
   encodeDisplay();
   //check for input on softSerial
   softSerialCheck();
@@ -400,10 +469,17 @@ void softSerialCheck()
       moistSection.toCharArray(moistChar, sizeof(moistSection));
       moistGoal = atoi(moistChar);
     }
+    //manual overrides below change relay state mid-interval, so settle the duty totals first
+    dutyAccumulate();
     //turn on light if Ll1 is received from imp cloud. note that normal cycling still applies: may go off moments later
-    if (inputString.indexOf("Ll1") > -1) digitalWrite(relayLight, HIGH);
-    //turn on pump if Pp1 is received from imp cloud. note that normal cycling still applies: may go off moments later
-    if (inputString.indexOf("Pp1") > -1) digitalWrite(relayWater, HIGH);
+    if (inputString.indexOf("Ll1") > -1 && !zones[0].on) lightSwitch(zones[0], true);
+    //run the pump for a window if Pp1 is received from imp cloud. pumpCheck switches it, and back to
+    //what the pid wants after
+    if (inputString.indexOf("Pp1") > -1)
+    {
+      pumpManual = true;
+      pumpManualStart = millis();
+    }
     inputString = "";
     stringComplete = false; 
   }
@@ -415,32 +491,48 @@ void checkSensors()
   light();
   temphum();
   moist();  
-  //check if any values have changed. if so, update display.
-  if (luxOld != luxNew || moistOld != moistNew || humidOld != humidNew || tempOld != tempNew) valueChange = true;
+  //check if any values have really changed, not just jittered. if so, update display.
+  //lux, moisture counts, tenths of a degree, tenths of a percent. single | so every channel updates its reference
+  if (luxStats.changed(5) | moistStats.changed(3) | tempStats.changed(2) | humidStats.changed(5)) valueChange = true;
 }
 
 void light()
 {
-  luxOld = luxNew;
-  lum = tsl.getFullLuminosity();
-  ir = lum >> 16;
-  full = lum & 0xFFFF;
-  visible = full - ir;
-  luxNew = tsl.calculateLux(full, ir);
+  //collect the integration started last time through, then start the next one. never waits on the sensor
+  if (tsl.integrationReady())
+  {
+    uint32_t lux;
+    //a saturated reading is retried at the next, less sensitive range
+    if (tsl.collectLuminosity(full, ir, lux))
+    {
+      lum = full;
+      visible = full - ir;
+      luxStats.update(lux);
+      luxNew = luxStats.getEMA();
+    }
+  }
+  if (!tsl.isIntegrating()) tsl.startIntegration();
 }
 
 void temphum()
 {
-  humidOld = humidNew;
-  tempOld = tempNew;
-  humidNew = dht.readHumidity();
-  tempNew = dht.readTemperature();
+  //dht22 only updates every 2 seconds; don't bother the sensor until there's a new sample
+  if (dht.sampleAge() < 2000) return;
+  //one transaction for both values. keep the old ones if the checksum fails
+  DHTReading reading;
+  if (dht.readBoth(reading))
+  {
+    humidStats.update(lround(reading.humidity * 10));
+    tempStats.update(lround(reading.temperature * 10));
+    humidNew = humidStats.getEMA() / 10.0;
+    tempNew = tempStats.getEMA() / 10.0;
+  }
 }
 
 void moist()
 {
-  moistOld = moistNew;
-  moistNew = analogRead(moisturePin);
+  moistStats.update(analogRead(moisturePin));
+  moistNew = moistStats.getEMA();
   //Serial.print("moisture level ");
   //Serial.println(moistNew);
 }
@@ -457,48 +549,161 @@ void updateEncoder()
   lastEncoded = encoded; //store this value for next time
 }
 
+//bring the duty-cycle totals up to now, crediting the time since the last call
+//to the state things were in during it
+void dutyAccumulate()
+{
+  unsigned long t = now();
+  unsigned long step = t - dutyLast;
+  if (!dutyStarted || t < dutyLast || step > DUTY_MAX_STEP) step = 0;
+  dutyLast = t;
+  dutyStarted = true;
+  if (step == 0) return;
+
+  dutyToday.total += step;
+  if (brightEnough) dutyToday.bright += step;
+  for (byte z = 0; z < NZONES; z++) lightAccumulate(zones[z], t, step);
+  //read the relay pins back so manual overrides from the imp are counted too
+  if (digitalRead(relayLight)) dutyToday.lightOn += step;
+  if (digitalRead(relayWater)) dutyToday.pumpOn += step;
+}
+
+//run the pump's time-proportioned window. called every loop so the on time is held to the millisecond
+void pumpCheck()
+{
+  unsigned long t = millis();
+  moistInput = moistNew;
+  moistSetpoint = moistGoal;
+  //the pid keeps its own sample clock. a late loop (the dht read alone is ~250 ms) delays its
+  //output, so windows start on a new output rather than on a clock of their own
+  if (moistPID.Compute())
+  {
+    pumpWindowStart = t;
+    pumpWindowOn = pumpOnTime * 1000;
+    //minimum dwell: no short blips on or off
+    if (pumpWindowOn < minPumpCycleTime * 1000UL) pumpWindowOn = 0;
+    if (pumpWindowOn > PUMP_WINDOW - minPumpCycleTime * 1000UL) pumpWindowOn = PUMP_WINDOW;
+  }
+
+  //a full window runs on into the next, however late that is
+  bool on = (pumpWindowOn >= PUMP_WINDOW || t - pumpWindowStart < pumpWindowOn);
+  if (pumpManual && t - pumpManualStart < PUMP_WINDOW) on = true;
+  else pumpManual = false;
+  if (on != pumpOn)
+  {
+    //credit the time up to here before the relay changes
+    dutyAccumulate();
+    pumpOn = on;
+    digitalWrite(relayWater, on ? HIGH : LOW);
+    if (on) Serial.println("turning water on");
+  }
+}
+
 //check whether a relay needs turned on
 void relayCheck()
 {
-//update time elapsed in total
-timeTotal = now();
-timeNew = timeTotal - timeOld;
-//Serial.print(timeNew);
-//Serial.print(now());
-
-//check water; turn on & increment time if below optimal level 
-if (moistNew < moistGoal)
+dutyAccumulate();
+brightEnough = (luxNew >= luxGoal);
+
+//light
+//proportion of today that has been bright enough, for display
+if (dutyToday.total > 0) lightProportion = (float)dutyToday.bright / dutyToday.total;
+else lightProportion = 0;
+
+for (byte z = 0; z < NZONES; z++) lightZoneCheck(zones[z]);
+}
+
+//credit step seconds of the zone's reading to its integrals
+void lightAccumulate(LightZone &zone, unsigned long t, unsigned long step)
 {
-  Serial.println("turning water on");
-  digitalWrite(relayWater, HIGH);
-  //todo: off by 5 seconds on this and light; fix?
-  timePumpOn = timePumpOn + timeNew;
+  uint32_t lux = *zone.lux;
+  //step is at most DUTY_MAX_STEP, so this stays well inside 32 bits
+  zone.luxSeconds += lux * step;
+  zone.luxHours += zone.luxSeconds / 3600;
+  zone.luxSeconds %= 3600;
+
+  byte hour = dayHour(t);
+  if (hour != zone.hour)
+  {
+    zone.daylight[zone.hour] = min(zone.hourSeconds / 3600, 65535UL);
+    zone.hourSeconds = 0;
+    zone.hour = hour;
+  }
+  if (zone.on) lux = (lux > zone.lampLux) ? lux - zone.lampLux : 0;
+  zone.hourSeconds += lux * step;
 }
-else digitalWrite(relayWater, LOW);
 
-//light
-//if luxNew > luxGoal, add timeNew to timeBrightEnough
-if (luxNew >= luxGoal)
+//hour of the current day, 0-23
+byte dayHour(unsigned long t)
 {
-  timeBrightEnough = timeBrightEnough + timeNew;
-  //Serial.print("time counts");
-  //Serial.println(timeBrightEnough);
-  //add to timeLightOn if light is on
+  unsigned long into = t - dayStart;
+  return (into < 86400UL) ? into / 3600 : 23;
 }
-//calculate lightProportion
-lightProportion = timeBrightEnough / timeTotal;
 
-//turn on light if proportion < goal //and (luxNew < luxGoal or light is on)
-if (lightProportion < lightProportionGoal && luxNew < luxGoal)
+//switch a zone's lamp. callers settle the duty totals first
+void lightSwitch(LightZone &zone, bool on)
 {
-  Serial.println("turning light on");
-  digitalWrite(relayLight, HIGH);
-  timeLightOn = timeLightOn + timeNew;
+  zone.on = on;
+  zone.luxAtSwitch = *zone.lux;
+  zone.switchedAt = now();
+  zone.settling = true;
+  if (on) zone.runsToday++;
+  digitalWrite(zone.relay, on ? HIGH : LOW);
+  if (on) Serial.println("turning light on");
 }
-//turn off light if lightroportion > lightproportiongoal
-if (lightProportion >= lightProportionGoal) digitalWrite(relayLight, LOW);
 
-timeOld = now();
+//decide whether a zone's lamp should be on. see LightZone above
+void lightZoneCheck(LightZone &zone)
+{
+  unsigned long t = now();
+  unsigned long ran = t - zone.switchedAt;
+  uint32_t lux = *zone.lux;
+
+  //the step in the reading once the switch has settled is the lamp. until then the reading
+  //is part way between, so nothing is decided on it
+  if (zone.settling)
+  {
+    if (ran < LAMP_SETTLE) return;
+    long step = zone.on ? (long)lux - (long)zone.luxAtSwitch : (long)zone.luxAtSwitch - (long)lux;
+    if (step > 0) zone.lampLux = (zone.lampLux + step) / 2;
+    zone.settling = false;
+  }
+  uint32_t lamp = zone.lampLux > 0 ? zone.lampLux : 1;
+
+  //light still owed today, and the daylight expected by the end of it: the current level
+  //to the end of this hour, then yesterday's for the hours after
+  uint32_t goal = luxGoal * lightProportionGoal * 24;
+  long remaining = (long)goal - (long)zone.luxHours;
+  unsigned long left = (t - dayStart < 86400UL) ? 86400UL - (t - dayStart) : 0;
+  uint32_t ambient = lux;
+  if (zone.on) ambient = (lux > lamp) ? lux - lamp : 0;
+  byte hour = dayHour(t);
+  uint32_t expected = ambient * (left % 3600) / 3600;
+  for (byte h = hour + 1; h < 24; h++) expected += zone.daylight[h];
+  long ahead = remaining - (long)expected;
+
+  //lamp seconds needed to make up the difference, stretched by the enforced rests if runs are capped
+  unsigned long need = 0;
+  if (ahead > 0) need = (unsigned long)ahead * 60 / lamp * 60;
+  if (lightCycle && maxLightCycleTime > 0) need += need / maxLightCycleTime * minLightCycleTime;
+
+  bool want;
+  if (remaining <= 0) want = false;
+  else if (zone.on) want = need + 2 * LIGHT_MARGIN > left;
+  else want = need + LIGHT_MARGIN >= left;
+
+  if (lightCycle)
+  {
+    if (ran < (unsigned long)minLightCycleTime) return;
+    if (zone.on && ran >= (unsigned long)maxLightCycleTime) want = false;
+  }
+  if (want && !zone.on && lightDaily && zone.runsToday >= maxLightsDaily) want = false;
+
+  if (want != zone.on)
+  {
+    dutyAccumulate();
+    lightSwitch(zone, want);
+  }
 }
 
 void sendData()
@@ -509,19 +714,47 @@ void sendData()
   char hum[10];
   dtostrf(humidNew,1,2,hum);
   toSend = String(toSend + "L" + luxNew + "L" + "M" + moistNew + "M" + "T" + temp + "T" + "H" + hum + "H");
+  //yesterday's duty totals ride along, so the cloud always has the last whole day: seconds counted,
+  //bright enough, lamp on, pump on
+  toSend = String(toSend + "D" + dutyYesterday.total + "D" + "S" + dutyYesterday.bright + "S" + "A" + dutyYesterday.lightOn + "A" + "W" + dutyYesterday.pumpOn + "W");
   //Serial.println(toSend);
   Serial.print("sending");
   Serial.println(toSend);
   softSerial.print(toSend);
 }
 
-void lightCheck()
-{
-    digitalWrite(relayLight, LOW);
-}
-
 void dayUpdate()
 {
+  //close out today's totals at this instant and start counting a new day
+  dutyAccumulate();
+  dutyYesterday = dutyToday;
+  dutyToday.total = dutyToday.bright = dutyToday.lightOn = dutyToday.pumpOn = 0;
+  dutyReport();
+  for (byte z = 0; z < NZONES; z++)
+  {
+    //last hour of the day into the profile; a new day starts in hour 0
+    zones[z].daylight[zones[z].hour] = min(zones[z].hourSeconds / 3600, 65535UL);
+    zones[z].hourSeconds = 0;
+    zones[z].hour = 0;
+    zones[z].luxHours = zones[z].luxSeconds = 0;
+    zones[z].runsToday = zones[z].on ? 1 : 0;
+  }
+  dayStart = now();
   daysLeft = daysLeft--;
   daysElapsed = daysElapsed++;  
 }
+
+//the day just closed, in seconds
+void dutyReport()
+{
+  Serial.print("day ");
+  Serial.print(daysElapsed);
+  Serial.print(": counted ");
+  Serial.print(dutyYesterday.total);
+  Serial.print(" bright ");
+  Serial.print(dutyYesterday.bright);
+  Serial.print(" lamp ");
+  Serial.print(dutyYesterday.lightOn);
+  Serial.print(" pump ");
+  Serial.println(dutyYesterday.pumpOn);
+}
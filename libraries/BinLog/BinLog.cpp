@@ -0,0 +1,128 @@
+#include <Arduino.h>
+#include "BinLog.h"
+
+#define BINLOG_MASK (BINLOG_BUFFER - 1)
+
+BinLog Log;
+
+BinLog::BinLog() {
+  port = 0;
+  head = tail = start = fill = 0;
+  overflow = false;
+  dropSince = 0;
+  dropTotal = 0;
+}
+
+void BinLog::begin(HardwareSerial &port, const char * const *formats, byte nFormats) {
+  this->port = &port;
+  for (byte id = 0; id < nFormats; id++) {
+    sendFormat(id, (const char *)pgm_read_word(&formats[id]));
+  }
+}
+
+// format records go straight out, the ring is too small for a table
+void BinLog::sendFormat(byte id, const char *format) {
+  byte len = 1 + min(strlen_P(format), 255 - 1);
+  unsigned long t = millis();
+  port->write(BINLOG_SYNC);
+  port->write(BINLOG_FORMAT);
+  port->write(len);
+  port->write((const uint8_t *)&t, sizeof(t));
+  port->write(id);
+  for (byte i = 1; i < len; i++) port->write(pgm_read_byte(format + i - 1));
+}
+
+BinLogRecord BinLog::event(byte id) {
+  open(id);
+  return( BinLogRecord(this) );
+}
+
+// free bytes in the ring, keeping one back so full and empty differ
+byte BinLog::space() {
+  return( BINLOG_MASK - ((head - tail) & BINLOG_MASK) );
+}
+
+void BinLog::open(byte id) {
+  // own up to earlier losses first, if both records will fit
+  if ( dropSince > 0 && space() >= 2 * BINLOG_HEADER + sizeof(dropSince) ) {
+    unsigned int n = dropSince;
+    dropSince = 0;
+    open(BINLOG_DROPPED);
+    put(&n, sizeof(n));
+    commit();
+  }
+
+  start = fill = head;
+  overflow = false;
+  unsigned long t = millis();
+  byte header[BINLOG_HEADER] = { BINLOG_SYNC, id, 0, 0, 0, 0, 0 };
+  memcpy(header + 3, &t, sizeof(t));
+  put(header, BINLOG_HEADER);
+}
+
+void BinLog::put(const void *data, byte n) {
+  byte used = fill - start;
+  if ( overflow || (byte)(space() - used) < n || used + n > BINLOG_MAX_RECORD ) {
+    overflow = true;
+    return;
+  }
+  const byte *b = (const byte *)data;
+  while ( n-- ) {
+    ring[fill & BINLOG_MASK] = *b++;
+    fill++;
+  }
+}
+
+void BinLog::commit() {
+  if ( overflow ) {
+    dropSince++;
+    dropTotal++;
+    return;
+  }
+  ring[(start + 2) & BINLOG_MASK] = (fill - start) - BINLOG_HEADER;
+  head = fill & BINLOG_MASK;
+}
+
+void BinLog::poll() {
+  if ( !port ) return;
+  while ( head != tail ) {
+    byte len = BINLOG_HEADER + ring[(tail + 2) & BINLOG_MASK];
+    // whole records only, so text printed in between can't split one
+    if ( port->availableForWrite() < len ) return;
+    while ( len-- ) {
+      port->write(ring[tail]);
+      tail = (tail + 1) & BINLOG_MASK;
+    }
+  }
+}
+
+void BinLog::flush() {
+  if ( !port ) return;
+  while ( head != tail ) {
+    port->write(ring[tail]);
+    tail = (tail + 1) & BINLOG_MASK;
+  }
+}
+
+byte BinLog::pending() {
+  return( (head - tail) & BINLOG_MASK );
+}
+
+unsigned long BinLog::getDropped() {
+  return( dropTotal );
+}
+
+BinLogRecord::~BinLogRecord() {
+  if ( log ) log->commit();
+}
+
+BinLogRecord &BinLogRecord::put(const void *data, byte n) {
+  if ( log ) log->put(data, n);
+  return( *this );
+}
+
+BinLogRecord &BinLogRecord::operator<<(const char *s) {
+  byte n = min(strlen(s), BINLOG_MAX_STRING);
+  put(&n, 1);
+  return( put(s, n) );
+}
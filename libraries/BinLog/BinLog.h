@@ -0,0 +1,138 @@
+#ifndef BinLog_h
+#define BinLog_h
+
+/*
+BinLog: buffered binary event log for a serial port.
+
+A record is an event id, a millis() timestamp and the raw bytes of its
+arguments.  Records go into a ring buffer and cost a few cycles a byte to
+write; poll() moves whole records into the HardwareSerial transmit buffer
+as it has room, and the UART interrupt sends them from there.  Nothing in
+the logging path waits on the serial port.  When the ring is full the
+record is dropped and counted, and a "dropped" record goes out ahead of
+the next one that fits.
+
+The text of each event lives in a PROGMEM format table that begin() sends
+once, as "NAME<tab>format" for each id, so a host decoder can turn records
+back into lines without a copy of the sketch (see tools/binlogdump).  Text
+written straight to the port in between is left alone: records start with
+BINLOG_SYNC, which is never printable text.
+
+  // LogEvents.h
+  #define LOG_EVENTS(X) \
+    X(LOG_PUMP, "%s: pump %b") \
+    X(LOG_MOIST, "moisture %u, temp %f F")
+  enum { LOG_EVENTS(BINLOG_ENUM) };
+
+  // sketch
+  LOG_EVENTS(BINLOG_STRING)
+  const char * const logFormats[] PROGMEM = { LOG_EVENTS(BINLOG_POINTER) };
+  Log.begin(Serial, logFormats, sizeof(logFormats) / sizeof(logFormats[0]));
+  Log.event(LOG_MOIST) << moist << temp;
+  Log.poll(); // every loop
+
+Format conversions give the size of each argument, in the order they are
+streamed (AVR sizes, little endian):
+  %b byte    %c char     %d int      %u unsigned int   %x unsigned int, hex
+  %ld long   %lu unsigned long       %lx unsigned long, hex
+  %f float or double (4 bytes on AVR) %s string, a length byte and the chars
+  %% a literal %
+
+A record has to fit in the port's transmit buffer to go out whole, so one
+longer than BINLOG_MAX_RECORD is dropped like one that didn't fit the ring.
+
+Records are written from loop() only, not from interrupt handlers.
+*/
+
+#include <Arduino.h>
+
+#define BINLOG_BUFFER 128      // ring size in bytes; a power of 2, at most 256
+#define BINLOG_MAX_STRING 24   // longer %s arguments are cut to this
+#define BINLOG_HEADER 7        // sync, id, length, 4 bytes of millis()
+// longest record, header and args: the most availableForWrite() ever reports
+#ifdef SERIAL_TX_BUFFER_SIZE
+#define BINLOG_MAX_RECORD (SERIAL_TX_BUFFER_SIZE - 1)
+#else
+#define BINLOG_MAX_RECORD 63
+#endif
+#define BINLOG_SYNC 0xF5       // starts every record
+#define BINLOG_FORMAT 0xFE     // reserved id: args are an event id and its name and format text
+#define BINLOG_DROPPED 0xFF    // reserved id: args are the number of records dropped (%u)
+
+// X macro helpers for an event list of X(id, "format") entries
+#define BINLOG_ENUM(id, fmt) id,
+#define BINLOG_STRING(id, fmt) const char id##_format[] PROGMEM = #id "\t" fmt;
+#define BINLOG_POINTER(id, fmt) id##_format,
+
+class BinLog;
+
+// one record being written.  made by BinLog::event(); committed when it goes
+// out of scope at the end of the statement, or dropped whole if it didn't fit.
+class BinLogRecord {
+  public:
+    BinLogRecord(BinLog *log) : log(log) {}
+    // the copy takes the record over, so it is only committed once
+    BinLogRecord(const BinLogRecord &other) : log(other.log) { other.log = 0; }
+    ~BinLogRecord();
+
+    BinLogRecord &operator<<(char v) { return put(&v, sizeof(v)); }
+    BinLogRecord &operator<<(signed char v) { return put(&v, sizeof(v)); }
+    BinLogRecord &operator<<(unsigned char v) { return put(&v, sizeof(v)); }
+    BinLogRecord &operator<<(bool v) { byte b = v; return put(&b, 1); }
+    BinLogRecord &operator<<(int v) { return put(&v, sizeof(v)); }
+    BinLogRecord &operator<<(unsigned int v) { return put(&v, sizeof(v)); }
+    BinLogRecord &operator<<(long v) { return put(&v, sizeof(v)); }
+    BinLogRecord &operator<<(unsigned long v) { return put(&v, sizeof(v)); }
+    BinLogRecord &operator<<(float v) { return put(&v, sizeof(v)); }
+    BinLogRecord &operator<<(double v) { float f = v; return put(&f, sizeof(f)); }
+    BinLogRecord &operator<<(const char *s);
+
+  private:
+    mutable BinLog *log; // 0 once committed or handed on
+    BinLogRecord &put(const void *data, byte n);
+};
+
+class BinLog {
+  public:
+    BinLog();
+
+    // send the format table (a PROGMEM array of nFormats PROGMEM strings, indexed
+    // by event id) and start logging to port.  blocks until the table is sent.
+    void begin(HardwareSerial &port, const char * const *formats, byte nFormats);
+
+    // start a record; stream its arguments into the result
+    BinLogRecord event(byte id);
+
+    // move whole records to the port, as far as its transmit buffer has room.
+    // call it every loop.
+    void poll();
+    // send everything queued, waiting on the port if need be
+    void flush();
+
+    // bytes queued and not yet handed to the port
+    byte pending();
+    // records lost to a full ring since begin()
+    unsigned long getDropped();
+
+  private:
+    friend class BinLogRecord;
+
+    HardwareSerial *port;
+    byte ring[BINLOG_BUFFER];
+    byte head, tail;         // head: next free byte.  tail: start of the oldest record
+    byte start;              // header of the record being written
+    byte fill;               // where its next argument byte goes
+    boolean overflow;        // it didn't fit
+    unsigned int dropSince;  // records dropped since the last dropped record went out
+    unsigned long dropTotal;
+
+    byte space();
+    void open(byte id);
+    void put(const void *data, byte n);
+    void commit();
+    void sendFormat(byte id, const char *format);
+};
+
+extern BinLog Log;
+
+#endif
@@ -11,6 +11,7 @@ DHT::DHT(uint8_t pin, uint8_t type, uint8_t count) {
   _type = type;
   _count = count;
   firstreading = true;
+  _lastresult = false;
 }
 
 void DHT::begin(void) {
@@ -22,30 +23,7 @@ void DHT::begin(void) {
 
 //boolean S == Scale.  True == Farenheit; False == Celcius
 float DHT::readTemperature(bool S) {
-  float f;
-
-  if (read()) {
-    switch (_type) {
-    case DHT11:
-      f = data[2];
-      if(S)
-      	f = convertCtoF(f);
-      	
-      return f;
-    case DHT22:
-    case DHT21:
-      f = data[2] & 0x7F;
-      f *= 256;
-      f += data[3];
-      f /= 10;
-      if (data[2] & 0x80)
-	f *= -1;
-      if(S)
-	f = convertCtoF(f);
-
-      return f;
-    }
-  }
+  if (read()) return decodeTemperature(S);
   return NAN;
 }
 
@@ -58,20 +36,70 @@ float DHT::convertFtoC(float f) {
 }
 
 float DHT::readHumidity(void) {
+  if (read()) return decodeHumidity();
+  return NAN;
+}
+
+// temperature and humidity from a single transaction.  returns the checksum status.
+boolean DHT::readBoth(DHTReading &reading, bool S) {
+  reading.checksumOK = read();
+  reading.timestamp = _lastreadtime;
+  if (reading.checksumOK) {
+    reading.temperature = decodeTemperature(S);
+    reading.humidity = decodeHumidity();
+  } else {
+    reading.temperature = NAN;
+    reading.humidity = NAN;
+  }
+  return reading.checksumOK;
+}
+
+// milliseconds since the last bus transaction; callers can skip the sensor while this is small.
+unsigned long DHT::sampleAge(void) {
+  if (firstreading) return 0xFFFFFFFF; // never read
+  return millis() - _lastreadtime;
+}
+
+float DHT::decodeTemperature(bool S) {
   float f;
-  if (read()) {
-    switch (_type) {
-    case DHT11:
-      f = data[0];
-      return f;
-    case DHT22:
-    case DHT21:
-      f = data[0];
-      f *= 256;
-      f += data[1];
-      f /= 10;
-      return f;
-    }
+
+  switch (_type) {
+  case DHT11:
+    f = data[2];
+    if(S)
+      f = convertCtoF(f);
+
+    return f;
+  case DHT22:
+  case DHT21:
+    f = data[2] & 0x7F;
+    f *= 256;
+    f += data[3];
+    f /= 10;
+    if (data[2] & 0x80)
+      f *= -1;
+    if(S)
+      f = convertCtoF(f);
+
+    return f;
+  }
+  return NAN;
+}
+
+float DHT::decodeHumidity(void) {
+  float f;
+
+  switch (_type) {
+  case DHT11:
+    f = data[0];
+    return f;
+  case DHT22:
+  case DHT21:
+    f = data[0];
+    f *= 256;
+    f += data[1];
+    f /= 10;
+    return f;
   }
   return NAN;
 }
@@ -105,7 +133,7 @@ boolean DHT::read(void) {
     _lastreadtime = 0;
   }
   if (!firstreading && ((currenttime - _lastreadtime) < 2000)) {
-    return true; // return last correct measurement
+    return _lastresult; // return status of the last measurement
     //delay(2000 - (currenttime - _lastreadtime));
   }
   firstreading = false;
@@ -168,12 +196,9 @@ boolean DHT::read(void) {
   */
 
   // check we read 40 bits and that the checksum matches
-  if ((j >= 40) && 
-      (data[4] == ((data[0] + data[1] + data[2] + data[3]) & 0xFF)) ) {
-    return true;
-  }
-  
+  _lastresult = (j >= 40) &&
+                (data[4] == ((data[0] + data[1] + data[2] + data[3]) & 0xFF));
 
-  return false;
+  return _lastresult;
 
 }
@@ -20,12 +20,22 @@ written by Adafruit Industries
 #define DHT21 21
 #define AM2301 21
 
+// one complete sample: both values come from the same bus transaction
+typedef struct {
+  float temperature;
+  float humidity;
+  boolean checksumOK;      // false if the 40 bits didn't arrive or didn't sum
+  unsigned long timestamp; // millis() when the sample was taken
+} DHTReading;
+
 class DHT {
  private:
   uint8_t data[6];
   uint8_t _pin, _type, _count;
   unsigned long _lastreadtime;
-  boolean firstreading;
+  boolean firstreading, _lastresult;
+  float decodeTemperature(bool S);
+  float decodeHumidity(void);
 
  public:
   DHT(uint8_t pin, uint8_t type, uint8_t count=6);
@@ -35,6 +45,8 @@ class DHT {
   float convertFtoC(float);
   float computeHeatIndex(float tempFahrenheit, float percentHumidity);
   float readHumidity(void);
+  boolean readBoth(DHTReading &reading, bool S=false);
+  unsigned long sampleAge(void);
   boolean read(void);
 
 };
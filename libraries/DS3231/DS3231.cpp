@@ -18,7 +18,9 @@ Released into the public domain.
 
 // Constructor
 DS3231::DS3231() {
-	// nothing to do for this constructor.
+	_cacheValid = false;
+	_cacheMillis = 0;
+	_cacheSlack = 0;
 }
 
 /***************************************** 
@@ -26,30 +28,15 @@ DS3231::DS3231() {
  *****************************************/
 
 void DS3231::getTime(byte& year, byte& month, byte& date, byte& DoW, byte& hour, byte& minute, byte& second) {
-	byte tempBuffer;
-	bool PM;
-	bool h12;
-
-	Wire.beginTransmission(CLOCK_ADDRESS);
-	Wire.write(uint8_t(0x00));
-	Wire.endTransmission();
-	
-	Wire.requestFrom(CLOCK_ADDRESS, 7);
-
-	second = bcdToDec(Wire.read());
-	minute = bcdToDec(Wire.read());
-	tempBuffer = bcdToDec(Wire.read());
-	h12 = tempBuffer & 0b01000000;
-	if (h12) {
-		PM = tempBuffer & 0b00100000;
-		hour = bcdToDec(tempBuffer & 0b00011111);
-	} else {
-		hour = bcdToDec(tempBuffer & 0b00111111);
-	}
-	DoW = bcdToDec(Wire.read());
-	date = bcdToDec(Wire.read());
-	month = bcdToDec(Wire.read() & 0b01111111);
-	year = bcdToDec(Wire.read());
+	DS3231Snapshot t;
+	getSnapshot(t);
+	second = t.second;
+	minute = t.minute;
+	hour = t.hour;
+	DoW = t.DoW;
+	date = t.date;
+	month = t.month;
+	year = t.year;
 }
 
 byte DS3231::getSecond() {
@@ -129,7 +116,83 @@ byte DS3231::getYear() {
 	return bcdToDec(Wire.read());
 }
 
+void DS3231::getSnapshot(DS3231Snapshot& t) {
+	byte tempBuffer;
+
+	Wire.beginTransmission(CLOCK_ADDRESS);
+	Wire.write(uint8_t(0x00));
+	Wire.endTransmission();
+
+	Wire.requestFrom(CLOCK_ADDRESS, 7);
+
+	t.second = bcdToDec(Wire.read());
+	t.minute = bcdToDec(Wire.read());
+	tempBuffer = Wire.read();
+	t.h12 = tempBuffer & 0b01000000;
+	if (t.h12) {
+		t.PM = tempBuffer & 0b00100000;
+		t.hour = bcdToDec(tempBuffer & 0b00011111);
+	} else {
+		t.PM = false;
+		t.hour = bcdToDec(tempBuffer & 0b00111111);
+	}
+	t.DoW = bcdToDec(Wire.read());
+	t.date = bcdToDec(Wire.read());
+	tempBuffer = Wire.read();
+	t.Century = tempBuffer & 0b10000000;
+	t.month = bcdToDec(tempBuffer & 0b01111111);
+	t.year = bcdToDec(Wire.read());
+	t.ms = 0;
+}
+
+// seconds since midnight, in 24-hour time
+static long secondOfDay(const DS3231Snapshot& t) {
+	byte hour = t.hour;
+	if (t.h12) hour = (hour % 12) + (t.PM ? 12 : 0);
+	return (hour * 3600L + t.minute * 60L + t.second);
+}
+
+void DS3231::getCachedTime(DS3231Snapshot& t) {
+	unsigned long now = millis();
+	unsigned long age = now - _cacheMillis;
+	// the next tick is due somewhere in the last _cacheSlack ms before
+	// _cacheMillis + 1000.  read in the middle of that, and whichever
+	// side of the tick the read lands, it halves the doubt.
+	if (!_cacheValid || age + _cacheSlack / 2 >= 1000) {
+		// the chip latches the time as the read starts
+		DS3231Snapshot s;
+		getSnapshot(s);
+		// when s's second started, relative to now: not after now, and
+		// less than 1000 ms before; and where the earlier reads put it,
+		// if that's tighter.  millis() can run off from the chip by 0.5%
+		// (a resonator), so their doubt widens by 1/128 of the time since
+		// on both sides.
+		long hi = 0, lo = -999;
+		if (_cacheValid) {
+			long since = now - _cacheMillis;
+			long k = secondOfDay(s) - secondOfDay(_cache);
+			if (k < 0) k += 86400L;	// past midnight
+			long predHi = 1000L * k - since + (since >> 7);
+			long predLo = 1000L * k - since - _cacheSlack - (since >> 7);
+			if (predHi >= lo && predLo <= hi) {
+				if (predHi < hi) hi = predHi;
+				if (predLo > lo) lo = predLo;
+			}
+			// otherwise the clock was set, or it's been too long: start over
+		}
+		_cache = s;
+		_cacheMillis = now + hi;
+		_cacheSlack = hi - lo;
+		_cacheValid = true;
+		age = -hi;
+	}
+	// less the most millis() can have run ahead of the chip's ms since
+	t = _cache;
+	t.ms = age - ((age + 127) >> 7);
+}
+
 void DS3231::setSecond(byte Second) {
+	_cacheValid = false;
 	// Sets the seconds 
 	// This function also resets the Oscillator Stop Flag, which is set
 	// whenever power is interrupted.
@@ -143,6 +206,7 @@ void DS3231::setSecond(byte Second) {
 }
 
 void DS3231::setMinute(byte Minute) {
+	_cacheValid = false;
 	// Sets the minutes 
 	Wire.beginTransmission(CLOCK_ADDRESS);
 	Wire.write(uint8_t(0x01));
@@ -151,6 +215,7 @@ void DS3231::setMinute(byte Minute) {
 }
 
 void DS3231::setHour(byte Hour) {
+	_cacheValid = false;
 	// Sets the hour, without changing 12/24h mode.
 	// The hour must be in 24h format.
 
@@ -183,6 +248,7 @@ void DS3231::setHour(byte Hour) {
 }
 
 void DS3231::setDoW(byte DoW) {
+	_cacheValid = false;
 	// Sets the Day of Week
 	Wire.beginTransmission(CLOCK_ADDRESS);
 	Wire.write(uint8_t(0x03));
@@ -191,6 +257,7 @@ void DS3231::setDoW(byte DoW) {
 }
 
 void DS3231::setDate(byte Date) {
+	_cacheValid = false;
 	// Sets the Date
 	Wire.beginTransmission(CLOCK_ADDRESS);
 	Wire.write(uint8_t(0x04));
@@ -199,6 +266,7 @@ void DS3231::setDate(byte Date) {
 }
 
 void DS3231::setMonth(byte Month) {
+	_cacheValid = false;
 	// Sets the month
 	Wire.beginTransmission(CLOCK_ADDRESS);
 	Wire.write(uint8_t(0x05));
@@ -207,6 +275,7 @@ void DS3231::setMonth(byte Month) {
 }
 
 void DS3231::setYear(byte Year) {
+	_cacheValid = false;
 	// Sets the year
 	Wire.beginTransmission(CLOCK_ADDRESS);
 	Wire.write(uint8_t(0x06));
@@ -215,6 +284,7 @@ void DS3231::setYear(byte Year) {
 }
 
 void DS3231::setClockMode(bool h12) {
+	_cacheValid = false;
 	// sets the mode to 12-hour (true) or 24-hour (false).
 	// One thing that bothers me about how I've written this is that
 	// if the read and right happen at the right hourly millisecnd,
@@ -487,6 +557,44 @@ bool DS3231::checkIfAlarm(byte Alarm) {
 	return result;
 }
 
+volatile bool DS3231::_alarmLatched = false;
+
+void DS3231::alarmISR() {
+	_alarmLatched = true;
+}
+
+bool DS3231::attachAlarmInterrupt(byte pin) {
+	// INT/SQW is open drain, active low.
+	byte interrupt;
+	switch (pin) {
+		case 2:
+			interrupt = 0;
+			break;
+		case 3:
+			interrupt = 1;
+			break;
+		default:
+			return false;
+	}
+	pinMode(pin, INPUT);
+	digitalWrite(pin, HIGH);	// pull-up
+	// set INTCN so the alarms, not the square wave, drive the pin
+	writeControlByte(readControlByte(0) | 0b00000100, 0);
+	_alarmLatched = false;
+	attachInterrupt(interrupt, alarmISR, FALLING);
+	return true;
+}
+
+bool DS3231::alarmLatched() {
+	// a single byte, so reading it can't tear; clear with interrupts off
+	// so an edge arriving in between isn't lost.
+	if (!_alarmLatched) return false;
+	noInterrupts();
+	_alarmLatched = false;
+	interrupts();
+	return true;
+}
+
 void DS3231::enableOscillator(bool TF, bool battery, byte frequency) {
 	// turns oscillator on or off. True is on, false is off.
 	// if battery is true, turns on even for battery-only operation,
@@ -19,6 +19,22 @@
 #include <Arduino.h>
 #include <Wire.h>
 
+// One consistent reading of the seven time registers (0x00-0x06).
+typedef struct {
+	byte second;
+	byte minute;
+	byte hour;
+	byte DoW;
+	byte date;
+	byte month;
+	byte year;		// last 2 digits only
+	bool h12;
+	bool PM;
+	bool Century;
+	unsigned int ms;	// milliseconds into the second, 0-999;
+				// only set by getCachedTime()
+} DS3231Snapshot;
+
 class DS3231 {
 	public:
 			
@@ -43,6 +59,21 @@ class DS3231 {
 			// Also sets the flag indicating century roll-over.
 		byte getYear(); 
 			// Last 2 digits only
+		void getSnapshot(DS3231Snapshot& t);
+			// Reads all seven time registers in a single I2C burst,
+			// so the fields can't tear across a rollover.
+		void getCachedTime(DS3231Snapshot& t);
+			// As getSnapshot(), but cheap enough for timestamping
+			// every reading: it works out from millis() when the
+			// clock's seconds tick, and only goes to the bus when
+			// one is due. t.ms is how far into the second it is.
+			// The tick can't be read directly, so each read is
+			// timed to halve the doubt about where it falls. It is
+			// never ahead of the chip. Called from a busy loop,
+			// it's one or two reads a second, the second turns
+			// over within ~15 ms of the chip's and t.ms runs ~15 ms
+			// behind; the further apart the calls, the less it can
+			// home in (tools/rtccheck).
 
 		// Time-setting functions
 		// Note that none of these check for sensibility: You can set the
@@ -112,6 +143,14 @@ class DS3231 {
 		bool checkIfAlarm(byte Alarm); 
 			// Checks whether the indicated alarm (1 or 2, 2 default);
 			// has been activated.
+		bool attachAlarmInterrupt(byte pin);
+			// Routes enabled alarms to the INT/SQW pin (sets INTCN) and
+			// latches its falling edge on external interrupt pin 2 or 3.
+			// Returns false for any other pin. enableOscillator(true,...)
+			// clears INTCN, so call this after it.
+		bool alarmLatched();
+			// True once per INT edge since the last call. The pin stays
+			// low until the alarm flag is cleared with checkIfAlarm().
 
 		// Oscillator functions
 
@@ -134,6 +173,15 @@ class DS3231 {
 
 	private:
 
+		DS3231Snapshot _cache;
+		unsigned long _cacheMillis;	// latest that _cache's second can have started
+		unsigned int _cacheSlack;	// and it started at most this many ms before that
+		bool _cacheValid;
+
+		static volatile bool _alarmLatched;
+		static void alarmISR();
+			// attachInterrupt() can't take a member function with a this
+
 		byte decToBcd(byte val); 
 			// Convert normal decimal numbers to binary coded decimal
 		byte bcdToDec(byte val); 
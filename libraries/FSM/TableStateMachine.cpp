@@ -0,0 +1,54 @@
+/*
+||
+|| @file TableStateMachine.cpp
+||
+|| @description
+|| | Table-driven transitions on top of FiniteStateMachine
+|| #
+||
+*/
+
+#include "TableStateMachine.h"
+
+TableStateMachine::TableStateMachine(State& current, const Transition* table, byte rows) : FiniteStateMachine(current) {
+	this->table = table;
+	this->rows = rows;
+	started = false;
+}
+
+boolean TableStateMachine::raise(byte event){
+	//the first update() runs the initial state's enter; don't exit a state that was never entered
+	if (!started){
+		update();
+	}
+	return fire(event);
+}
+
+TableStateMachine& TableStateMachine::update(){
+	if (started){
+		fire(FSM_TIMED);
+	}
+	FiniteStateMachine::update();
+	started = true;
+	return *this;
+}
+
+boolean TableStateMachine::fire(byte event){
+	State* current = &getCurrentState();
+	Transition row;
+	for (byte i = 0; i < rows; i++){
+		memcpy_P(&row, &table[i], sizeof(row));
+		if (row.from != current || row.event != event){
+			continue;
+		}
+		if (event == FSM_TIMED && timeInCurrentState() < row.after){
+			continue;
+		}
+		if (row.guard && !row.guard()){
+			continue;
+		}
+		immediateTransitionTo(*row.to);
+		return true;
+	}
+	return false;
+}
@@ -0,0 +1,57 @@
+/*
+||
+|| @file TableStateMachine.h
+||
+|| @description
+|| | A FiniteStateMachine whose transitions are listed in a table instead of
+|| | being coded into the state functions. Each row names the state it leaves,
+|| | the event that triggers it (or FSM_TIMED for a row that fires on its own
+|| | after some time in the state), an optional guard, and the state it enters.
+|| | The table lives in PROGMEM, so it costs no RAM however long it gets.
+|| #
+||
+|| @license
+|| | This library is free software; you can redistribute it and/or
+|| | modify it under the terms of the GNU Lesser General Public
+|| | License as published by the Free Software Foundation; version
+|| | 2.1 of the License.
+|| #
+||
+*/
+
+#ifndef TABLESTATEMACHINE_H
+#define TABLESTATEMACHINE_H
+
+#include "FiniteStateMachine.h"
+#include <avr/pgmspace.h>
+
+#define FSM_TIMED (0)
+#define NO_GUARD (0)
+
+//one row of a transition table
+typedef struct {
+	State* from;
+	byte event;			//FSM_TIMED, or an event passed to raise()
+	unsigned long after;	//ms in from before a FSM_TIMED row may fire; ignored for other events
+	boolean (*guard)();	//the row only fires if this returns true. NO_GUARD always fires
+	State* to;
+} Transition;
+
+//rows are tried in order and the first match wins, so put guarded rows ahead of their fallback
+class TableStateMachine : public FiniteStateMachine {
+	public:
+		TableStateMachine(State& current, const Transition* table, byte rows);
+		
+		//fire the first row for the current state that matches event; true if one did
+		boolean raise(byte event);
+		//fire the first timed row that is due, then update the current state
+		TableStateMachine& update();
+		
+	private:
+		boolean fire(byte event);
+		const Transition* table;
+		byte rows;
+		boolean started;
+};
+
+#endif
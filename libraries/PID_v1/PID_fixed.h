@@ -0,0 +1,205 @@
+#ifndef PID_fixed_h
+#define PID_fixed_h
+
+#if ARDUINO >= 100
+  #include "Arduino.h"
+#else
+  #include "WProgram.h"
+#endif
+
+#include <PID_v1.h>
+
+/* PIDFixed<FRAC> ***************************************************************
+ *  The same controller as PID, with the same calls, but Compute() only does
+ *  integer math.  Input, Output and Setpoint are longs in whatever units the
+ *  sketch uses (adc counts, ms of a relay window...).  Internally the gains
+ *  and the integral are fixed point with FRAC fraction bits; tunings are still
+ *  given as doubles and converted once in SetTunings().
+ *
+ *  Each term (kp*error, ITerm, kd*dInput) has to stay below 2^(29-FRAC) in
+ *  output units or the 32-bit sum overflows.  PID_Q16 (Q.16) tracks the float
+ *  PID to within rounding for outputs below 8192.  PID_Q8 (Q.8) reaches outputs
+ *  in the millions, but Ki * sample time is only kept to 1/256, so small integral
+ *  gains drift from what the float version would do.  tools/pidcheck runs both
+ *  next to the float PID on a host.
+ ******************************************************************************/
+template <uint8_t FRAC>
+class PIDFixed
+{
+  public:
+
+    PIDFixed(long* Input, long* Output, long* Setpoint,
+        double Kp, double Ki, double Kd, int ControllerDirection)
+    {
+      myOutput = Output;
+      myInput = Input;
+      mySetpoint = Setpoint;
+      inAuto = false;
+
+      // zeroed first: SetTunings() leaves them alone when handed a negative gain
+      dispKp = dispKi = dispKd = 0;
+      kp = ki = kd = 0;
+      controllerDirection = DIRECT;
+      ITerm = 0;
+      lastInput = 0;
+
+      SetOutputLimits(0, 255);
+
+      SampleTime = 100;
+
+      SetControllerDirection(ControllerDirection);
+      SetTunings(Kp, Ki, Kd);
+
+      lastTime = millis()-SampleTime;
+    }
+
+    void SetMode(int Mode)
+    {
+      bool newAuto = (Mode == AUTOMATIC);
+      if(newAuto && !inAuto)
+      {  /*we just went from manual to auto*/
+        Initialize();
+      }
+      inAuto = newAuto;
+    }
+
+    bool Compute()
+    {
+      if(!inAuto) return false;
+      unsigned long now = millis();
+      unsigned long timeChange = (now - lastTime);
+      if(timeChange>=SampleTime)
+      {
+        /*Compute all the working error variables*/
+        long input = *myInput;
+        long error = *mySetpoint - input;
+        ITerm += ki * error;
+        if(ITerm > outMaxQ) ITerm = outMaxQ;
+        else if(ITerm < outMinQ) ITerm = outMinQ;
+        long dInput = (input - lastInput);
+
+        /*Compute PID Output*/
+        long output = kp * error + ITerm - kd * dInput;
+
+        if(output > outMaxQ) output = outMaxQ;
+        else if(output < outMinQ) output = outMinQ;
+        *myOutput = (output + HALF) >> FRAC;
+
+        /*Remember some variables for next time*/
+        lastInput = input;
+        lastTime = now;
+        return true;
+      }
+      else return false;
+    }
+
+    void SetOutputLimits(long Min, long Max)
+    {
+      if(Min >= Max) return;
+      outMin = Min;
+      outMax = Max;
+      outMinQ = Min << FRAC;
+      outMaxQ = Max << FRAC;
+
+      if(inAuto)
+      {
+        if(*myOutput > outMax) *myOutput = outMax;
+        else if(*myOutput < outMin) *myOutput = outMin;
+
+        if(ITerm > outMaxQ) ITerm = outMaxQ;
+        else if(ITerm < outMinQ) ITerm = outMinQ;
+      }
+    }
+
+    void SetTunings(double Kp, double Ki, double Kd)
+    {
+      if (Kp<0 || Ki<0 || Kd<0) return;
+
+      dispKp = Kp; dispKi = Ki; dispKd = Kd;
+
+      double SampleTimeInSec = ((double)SampleTime)/1000;
+      kp = toFixed(Kp);
+      ki = toFixed(Ki * SampleTimeInSec);
+      kd = toFixed(Kd / SampleTimeInSec);
+
+      if(controllerDirection == REVERSE)
+      {
+        kp = (0 - kp);
+        ki = (0 - ki);
+        kd = (0 - kd);
+      }
+    }
+
+    void SetControllerDirection(int Direction)
+    {
+      if(inAuto && Direction != controllerDirection)
+      {
+        kp = (0 - kp);
+        ki = (0 - ki);
+        kd = (0 - kd);
+      }
+      controllerDirection = Direction;
+    }
+
+    // re-derives ki and kd from the user tunings rather than scaling the
+    // rounded fixed point values, so repeated changes don't drift
+    void SetSampleTime(int NewSampleTime)
+    {
+      if (NewSampleTime > 0)
+      {
+        SampleTime = (unsigned long)NewSampleTime;
+        SetTunings(dispKp, dispKi, dispKd);
+      }
+    }
+
+    double GetKp(){ return dispKp; }
+    double GetKi(){ return dispKi; }
+    double GetKd(){ return dispKd; }
+    int GetMode(){ return inAuto ? AUTOMATIC : MANUAL; }
+    int GetDirection(){ return controllerDirection; }
+
+  private:
+
+    static const long HALF = (FRAC > 0) ? (1L << FRAC) >> 1 : 0;
+
+    static long toFixed(double x)
+    {
+      return (long)(x * (double)(1L << FRAC) + (x < 0 ? -0.5 : 0.5));
+    }
+
+    void Initialize()
+    {
+      ITerm = *myOutput << FRAC;
+      lastInput = *myInput;
+      if(ITerm > outMaxQ) ITerm = outMaxQ;
+      else if(ITerm < outMinQ) ITerm = outMinQ;
+    }
+
+    double dispKp;              // * tuning parameters as the user entered them
+    double dispKi;
+    double dispKd;
+
+    long kp;                    // * the working gains, Q.FRAC, with the sample
+    long ki;                    //   time and direction folded in
+    long kd;
+
+    int controllerDirection;
+
+    long *myInput;
+    long *myOutput;
+    long *mySetpoint;
+
+    unsigned long lastTime;
+    long ITerm;                 // * Q.FRAC
+    long lastInput;
+
+    unsigned long SampleTime;
+    long outMin, outMax;
+    long outMinQ, outMaxQ;      // * the limits in Q.FRAC, for clamping ITerm and the sum
+    bool inAuto;
+};
+
+typedef PIDFixed<8> PID_Q8;
+typedef PIDFixed<16> PID_Q16;
+
+#endif
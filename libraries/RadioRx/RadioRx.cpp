@@ -0,0 +1,295 @@
+#include "RadioRx.h"
+
+#ifndef ARDUINO
+#include <string.h>
+#define HIGH 1
+#define noInterrupts()
+#define interrupts()
+#endif
+
+// expected +/- tolerance, for a time of n pulses of unit us.  multiplies and shifts only:
+// this runs in the ISR, and a 32-bit divide is ~40 us on an AVR.
+static inline void window(unsigned long unit, unsigned long n, unsigned long &lo, unsigned long &hi) {
+  unsigned long w = unit * n;
+  unsigned long tol = w >> RADIORX_TOL_SHIFT;
+  if ( tol < (unit >> 1) ) tol = unit >> 1;
+  lo = w - tol;
+  hi = w + tol;
+}
+
+// mark the bins within tolerance of n pulses (the same rule as window(), in quarters)
+static void markClass(byte *table, byte bins, int n, byte bit) {
+  int c = n << 2;
+  int tol = c >> RADIORX_TOL_SHIFT;
+  if ( tol < 2 ) tol = 2;
+  for (int q = c - tol < 0 ? 0 : c - tol; q <= c + tol && q < bins - 1; q++) table[q] |= bit;
+}
+
+// a time in quarters of the frame's pulse length, scale being quarters per us in 16.16.
+// out of range goes to the last bin, which is invalid.
+static inline byte quantize(unsigned long d, unsigned long scale, byte bins) {
+  if ( d >= 65536UL ) return ( bins - 1 );
+  unsigned long q = (d * scale) >> 16;
+  return ( q < bins ? q : bins - 1 );
+}
+
+void RadioRx::begin(const RadioProtocol *protocols, RadioChannel *channels, byte n) {
+  proto = protocols;
+  chan = channels;
+  nProt = n > RADIORX_PROTOCOLS ? RADIORX_PROTOCOLS : n;
+  repeat = RADIORX_REPEAT;
+
+  // start from the spec timings
+  memset((void *)chan, 0, nProt * sizeof(RadioChannel));
+  memset(highClass, 0, sizeof(highClass));
+  memset(lowClass, 0, sizeof(lowClass));
+  for (byte p = 0; p < nProt; p++) {
+    const RadioProtocol &r = proto[p];
+    RadioChannel &c = chan[p];
+    c.unit = r.pulseLength;
+    window(r.pulseLength, r.sync[1], c.syncLo, c.syncHi);
+    c.wideLo = ((unsigned long)r.pulseLength * r.sync[1] * 100) / RADIORX_SLOP;
+    c.wideHi = ((unsigned long)r.pulseLength * r.sync[1] * RADIORX_SLOP) / 100;
+    c.unitLo = ((unsigned long)r.pulseLength * 100) / RADIORX_SLOP;
+    c.unitHi = ((unsigned long)r.pulseLength * RADIORX_SLOP) / 100;
+
+    markClass(highClass, RADIORX_QHIGH, r.zero[0], 1 << (2 * p));
+    markClass(lowClass, RADIORX_QLOW, r.zero[1], 1 << (2 * p));
+    markClass(highClass, RADIORX_QHIGH, r.one[0], 2 << (2 * p));
+    markClass(lowClass, RADIORX_QLOW, r.one[1], 2 << (2 * p));
+  }
+
+  ready = 0;
+  noise = 0;
+  picked = -1;
+}
+
+#ifdef ARDUINO
+// glue for attach().  ISRs can't be member functions.
+static RadioRx *attached;
+static volatile uint8_t *rxIn;
+static byte rxMask, rxInt;
+
+static void rxISR() {
+  static unsigned long lastTime;
+  // set this soonest so we don't lose time from later calcs.
+  unsigned long currTime = micros();
+  unsigned long deltaTime = currTime - lastTime;
+  lastTime = currTime;
+  attached->edge(deltaTime, (*rxIn & rxMask) ? HIGH : LOW, millis());
+}
+
+// valid rxPins found in http://arduino.cc/en/Reference/attachInterrupt
+// for Uno: D2,D3
+boolean RadioRx::attach(int rxPin) {
+  switch (rxPin) {
+    case 2:
+      rxInt = 0;
+      break;
+    case 3:
+      rxInt = 1;
+      break;
+    default:
+      return ( false );
+  }
+  pinMode(rxPin, INPUT);
+  // the pin's port and bit, so the ISR reads it in one instruction rather than a digitalRead()
+  rxIn = portInputRegister(digitalPinToPort(rxPin));
+  rxMask = digitalPinToBitMask(rxPin);
+  attached = this;
+  attachInterrupt(rxInt, rxISR, CHANGE);
+  return ( true );
+}
+
+void RadioRx::detach() {
+  if ( attached == this ) detachInterrupt(rxInt);
+  attached = 0;
+}
+#endif
+
+// Thar be dragons--prepare for battle.
+// frames are decoded even while one is waiting to be clear()ed, so the ones lost to that
+// can be counted; they go into a private shift register and are only published when free.
+void RadioRx::edge(unsigned long deltaTime, byte level, unsigned long now) {
+
+  // was this edge any use to anyone?
+  boolean heard = false;
+
+  for ( byte p = 0; p < nProt; p++ ) {
+    const RadioProtocol &r = proto[p];
+    RadioChannel &c = chan[p];
+
+    // track end-of-message
+    boolean eom = false;
+
+    if ( level == HIGH ) {
+      boolean inFrame = c.gotSync;
+      if ( c.gotSync ) {
+        // we have a previous sync, so decode bit stream: one table lookup for the (HIGH, LOW) pair.
+        byte low = quantize(deltaTime, c.scale, RADIORX_QLOW);
+        byte sym = (highClass[c.high] & lowClass[low]) >> (2 * p) & 3;
+        // a gap in another protocol's frame can pass for a sync, and then fails its first bit.
+        // those aren't frames, so a frame only counts from its first good bit.
+        if ( sym != 0 && c.counts == 0 ) c.stats.syncs++;
+        if ( sym == 2 ) {
+          // Rx == 1
+          c.counts++;
+          c.val = (c.val << 1) + 1; // bitshift current value up and add one at LSB
+        } else if ( sym == 1 ) {
+          // Rx == 0
+          c.counts++;
+          c.val = (c.val << 1) + 0; // bitshift current value up and add zero at LSB
+        } else {
+          // uh oh, we got nonsense.  blame the HIGH if it fits no bit at all.
+          if ( c.counts > 0 ) {
+            if ( (highClass[c.high] >> (2 * p) & 3) == 0 ) c.stats.badHigh++;
+            else c.stats.badLow++;
+          }
+          c.gotSync = false;
+        }
+      }
+      // establish a sync.  frames start with a long LOW time, so we'll catch HIGH transition.
+      // a gap that just broke a frame may be the next one's sync.
+      if ( ! c.gotSync ) {
+        // near the learned sync, or anywhere in the wide window if we've lost the sender
+        boolean wide = !c.locked || now - c.lastGood > RADIORX_RELOCK;
+        if ( wide ? (deltaTime >= c.wideLo && deltaTime <= c.wideHi)
+                  : (deltaTime >= c.syncLo && deltaTime <= c.syncHi) ) {
+          // that's a sync signal
+          c.gotSync = true;
+          c.val = 0; // reset val
+          c.counts = 0; // reset counts
+          // quarter pulses per us for this sender, from its sync gap.  a divide, but once a frame.
+          c.sync = deltaTime;
+          c.scale = ((unsigned long)r.sync[1] << 18) / deltaTime;
+        }
+      }
+      heard |= inFrame || c.gotSync;
+    } else if ( c.gotSync ) {
+      // so, we're got a sync, but the pin has just gone LOW.  keep the HIGH time for the next bit.
+      c.high = quantize(deltaTime, c.scale, RADIORX_QHIGH);
+      heard = true;
+
+      // maybe we've got enough bits?
+      if ( c.counts >= r.bits ) {
+        eom = true;
+      }
+    }
+
+    // we've reached the end of message, and it's a good one
+    if ( eom ) {
+      if ( repeat && c.val == c.lastVal && now - c.lastTime < repeat ) {
+        c.stats.repeats++;
+      } else if ( ready & (1 << p) ) {
+        c.stats.busy++;
+      } else {
+        c.rxVal = c.val;
+        ready |= 1 << p;
+        c.stats.frames++;
+      }
+      c.lastVal = c.val;
+      c.lastTime = now;
+
+      // pull the protocol's pulse length toward this one, and its sync window with it
+      int step = (int)(c.sync / r.sync[1]) - (int)c.unit;
+      if ( c.locked ) step /= (1 << RADIORX_LEARN_SHIFT); // first one: take it as is
+      unsigned int unit = c.unit + step;
+      if ( unit < c.unitLo ) unit = c.unitLo;
+      if ( unit > c.unitHi ) unit = c.unitHi;
+      c.unit = unit;
+      window(unit, r.sync[1], c.syncLo, c.syncHi);
+      c.lastGood = now;
+      c.locked = true;
+
+      // reset sync for next time.
+      c.gotSync = false;
+    }
+  }
+
+  if ( !heard ) noise++;
+}
+
+boolean RadioRx::available() {
+  if ( picked < 0 ) {
+    byte r = ready;
+    for (byte p = 0; p < nProt; p++) {
+      if ( r & (1 << p) ) {
+        picked = p;
+        break;
+      }
+    }
+  }
+  return( picked >= 0 );
+}
+
+int RadioRx::protocol() {
+  if ( available() ) return( picked );
+  return( -1 );
+}
+
+byte RadioRx::bits() {
+  if ( available() ) return( proto[picked].bits );
+  return( 0 );
+}
+
+unsigned long RadioRx::message() {
+  if ( available() ) return( chan[picked].rxVal );
+  return( 0 );
+}
+
+void RadioRx::clear() {
+  noInterrupts();
+  if ( picked >= 0 ) ready &= ~(1 << picked);
+  else ready = 0;
+  interrupts();
+  picked = -1;
+}
+
+void RadioRx::getStats(byte prot, RadioStats &stats) {
+  volatile RadioStats &s = chan[prot].stats;
+  noInterrupts();
+  stats.syncs = s.syncs;
+  stats.frames = s.frames;
+  stats.busy = s.busy;
+  stats.repeats = s.repeats;
+  stats.badHigh = s.badHigh;
+  stats.badLow = s.badLow;
+  interrupts();
+}
+
+unsigned long RadioRx::getNoise() {
+  noInterrupts();
+  unsigned long n = noise;
+  interrupts();
+  return( n );
+}
+
+void RadioRx::clearStats() {
+  noInterrupts();
+  for (byte p = 0; p < nProt; p++) {
+    volatile RadioStats &s = chan[p].stats;
+    s.syncs = s.frames = s.busy = 0;
+    s.repeats = s.badHigh = s.badLow = 0;
+  }
+  noise = 0;
+  interrupts();
+}
+
+unsigned int RadioRx::getUnit(byte prot) {
+  noInterrupts();
+  unsigned int unit = chan[prot].unit;
+  interrupts();
+  return( unit );
+}
+
+void RadioRx::setRepeat(unsigned int ms) {
+  repeat = ms;
+}
+
+byte RadioRx::getProtocols() {
+  return( nProt );
+}
+
+const RadioProtocol &RadioRx::getProtocol(byte prot) {
+  return( proto[prot] );
+}
@@ -0,0 +1,184 @@
+#ifndef RadioRx_h
+#define RadioRx_h
+
+/*
+RadioRx: receive 433 MHz OOK frames, of any set of protocols at once.
+
+A protocol is a pulse length, a bit count, and the sync, zero and one
+sequences as {HIGH, LOW} in pulses, the same terms RadioSniff learns them
+in.  The frame starts with the sync's LOW gap; each bit is a HIGH and a LOW.
+Every protocol given to begin() has its own decoder, and they all see every
+edge, so a frame of one can't hide an overlapping frame of another.
+
+Per edge, a bit costs one table lookup: the HIGH and LOW times, in quarters
+of the frame's pulse length, index a classifier built by begin().  The pulse
+length is learned from each good frame's sync gap, so a sender whose clock
+drifts with temperature stays decodable, and the sync window follows it.
+
+The frames, the timing and the link counters all live in one RadioChannel
+per protocol, which the sketch provides, so a sketch pays RAM for just the
+protocols it uses.
+
+  const RadioProtocol protocols[] = { RADIO_TB304BC, RADIO_ETEK };
+  RadioChannel channels[2];
+  RadioRx rx;
+
+  rx.begin(protocols, channels, 2);
+  rx.attach(2); // D2
+  ...
+  if ( rx.available() ) {
+    if ( rx.protocol() == 0 ) Serial << biosAddress(rx.message()) << endl;
+    rx.clear();
+  }
+
+A sketch with its own ISR calls edge() from it instead of attach().  Plain
+C++ apart from attach(), so tools/radiodecode runs this same decoder on a
+host, next to a reference one.
+*/
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include <stdint.h>
+typedef uint8_t byte;
+typedef bool boolean;
+#endif
+
+#define RADIORX_PROTOCOLS 4     // at most; the classifier has 2 bits for each
+#define RADIORX_SLOP 150        // until a protocol has been heard, its sync can be this percent off from spec.
+// once frames are coming in, windows are the expected time +/- 1/2^RADIORX_TOL_SHIFT of it
+// (but never tighter than half a pulse).
+#define RADIORX_TOL_SHIFT 2     // 25%
+#define RADIORX_LEARN_SHIFT 3   // learned pulse length moves 1/8 of the way to each frame's
+#define RADIORX_RELOCK 600000UL // ms. heard nothing for this long: back to the RADIORX_SLOP sync window
+// classifier bins, in quarter pulses; the last one is always invalid.  the longest HIGH or LOW
+// of a bit has to be under (bins - 1) / 4 pulses.
+#define RADIORX_QHIGH 20
+#define RADIORX_QLOW 48
+#define RADIORX_REPEAT 1000U    // ms. the same frame again within this is a repeat, and isn't delivered twice.
+
+// a protocol.  sequences are {HIGH, LOW}, in pulses.
+typedef struct {
+  byte bits;                // frame length, up to 32
+  unsigned int pulseLength; // us
+  byte sync[2];
+  byte zero[2];
+  byte one[2];
+} RadioProtocol;
+
+// Thermor BIOS Wireless Moisture and Temperature Sensor (TB304BC)
+// see http://rayshobby.net/reverse-engineer-a-cheap-wireless-soil-moisture-sensor/
+// a sync of 9000 us LOW, then a 475 us HIGH ahead of each bit: a one's LOW is 4000 us, a zero's 2000 us.
+#define RADIO_TB304BC { 32, 475, { 1, 18 }, { 1, 4 }, { 1, 8 } }
+// Etekcity outlets
+// see https://code.google.com/p/rc-switch/wiki/KnowHow_LineCoding
+// 180 us pulses.  sync 1 HIGH + 31 LOW; zero 1 HIGH + 3 LOW; one 3 HIGH + 1 LOW.
+#define RADIO_ETEK { 24, 180, { 1, 31 }, { 1, 3 }, { 3, 1 } }
+
+// the TB304BC frame, MSB first: a 9-bit address, 3 flag bits that change with the sensor's state,
+// 12 bits of temperature in tenths of a degree C (two's complement), 4 bits of moisture, and 4 more.
+// match sensors on the address alone; the flags make the first 12 bits wander.
+inline unsigned int biosAddress(unsigned long frame) { return ( frame >> 23 ); }
+inline byte biosFlags(unsigned long frame) { return ( (frame >> 20) & 7 ); }
+inline int biosTemp(unsigned long frame) {
+  int t = (frame >> 8) & 0xFFF;
+  return ( t & 0x800 ? t - 0x1000 : t );
+}
+// 0-3 (dry), 4-7 (damp), 8-11 (wet)
+inline byte biosMoist(unsigned long frame) { return ( (frame >> 4) & 15 ); }
+// the last byte, moisture and all
+inline byte biosHumidity(unsigned long frame) { return ( frame & 0xFF ); }
+
+// link-quality counters for one protocol, kept by the decoder.  16 bits, so read and
+// clear them more often than they can wrap.
+typedef struct {
+  unsigned int syncs;   // frames started: a sync gap and then at least one good bit
+  unsigned int frames;  // full-length frames delivered
+  unsigned int busy;    // full-length frames lost because the last one of this protocol hadn't been clear()ed
+  unsigned int repeats; // full-length frames identical to the last, within the repeat window
+  unsigned int badHigh; // started frames abandoned on a HIGH pulse of the wrong length
+  unsigned int badLow;  // started frames abandoned on a LOW gap that is neither a one nor a zero
+} RadioStats;
+
+// one protocol's decoder, timing and mailbox.  the sketch provides them; RadioRx keeps them.
+typedef struct {
+  // decoder
+  boolean gotSync;         // have we gotten a valid sync signal?
+  byte counts;             // bits received since sync
+  unsigned long val;       // frame being received
+  unsigned long sync;      // its sync gap
+  unsigned long scale;     // quarter pulses per us, 16.16, from the sync gap
+  byte high;               // the last HIGH, quantized
+  unsigned long lastVal;   // last full-length frame, delivered or not, for spotting repeats
+  unsigned long lastTime;  // ms
+  // timing
+  volatile unsigned int unit;       // learned pulse length, us
+  unsigned long syncLo, syncHi;     // sync window around it
+  unsigned long wideLo, wideHi;     // RADIORX_SLOP sync window around the spec
+  unsigned int unitLo, unitHi;      // and the pulse lengths it allows
+  unsigned long lastGood;           // ms of the last good frame
+  boolean locked;                   // heard at least once
+  // mailbox
+  volatile unsigned long rxVal;
+  volatile RadioStats stats;
+} RadioChannel;
+
+class RadioRx {
+  public:
+    // listen for n protocols (up to RADIORX_PROTOCOLS), each with a channel.  both arrays have to
+    // outlive the RadioRx; protocol numbers below are indexes into them.
+    void begin(const RadioProtocol *protocols, RadioChannel *channels, byte n);
+#ifdef ARDUINO
+    // take the edges from rxPin's interrupt (D2 or D3 on an Uno).  false if it has none.
+    // one RadioRx can be attached at a time.
+    boolean attach(int rxPin);
+    void detach();
+#endif
+
+    // one edge.  level is the pin now, deltaTime (us) how long it was at the other level,
+    // and now is millis().  the ISR's work: call it from a sketch's own ISR instead of attach().
+    void edge(unsigned long deltaTime, byte level, unsigned long now);
+
+    // is there a frame?  frames of different protocols wait side by side; this picks one, and
+    // the calls below are about that one until it's clear()ed, whatever else arrives meanwhile.
+    boolean available();
+    // its protocol, or -1 if there's none
+    int protocol();
+    // its bit count, or 0
+    byte bits();
+    // the frame, or 0
+    unsigned long message();
+    // no new frames of the picked protocol are kept until this.  with none picked, clears them all.
+    void clear();
+
+    // link quality: counters for protocol prot since the last clearStats()
+    void getStats(byte prot, RadioStats &stats);
+    // edges that weren't part of a frame or a sync: a busy band, or a receiver hearing only noise
+    unsigned long getNoise();
+    void clearStats();
+    // pulse length learned for protocol prot, in us
+    unsigned int getUnit(byte prot);
+
+    // how long a repeated frame is dropped for, ms.  0 delivers every one.
+    void setRepeat(unsigned int ms);
+
+    byte getProtocols();
+    const RadioProtocol &getProtocol(byte prot);
+
+  private:
+    const RadioProtocol *proto;
+    RadioChannel *chan;
+    byte nProt;
+    unsigned int repeat;
+    // symbol classifier.  a time in quarter pulses indexes one of these; bit 2p set means it can
+    // lead or follow a zero of protocol p, bit 2p+1 a one.  a symbol's template is a rectangle of
+    // HIGH and LOW windows, so highClass[h] & lowClass[l] is the whole 2D table, in 68 bytes.
+    byte highClass[RADIORX_QHIGH], lowClass[RADIORX_QLOW];
+    // bit p: chan[p].rxVal holds a frame
+    volatile byte ready;
+    volatile unsigned long noise;
+    // protocol available() picked, or -1
+    int picked;
+};
+
+#endif
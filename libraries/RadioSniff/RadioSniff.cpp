@@ -0,0 +1,180 @@
+#include "RadioSniff.h"
+
+RadioSniff::RadioSniff() {
+  clear();
+}
+
+void RadioSniff::clear() {
+  nProtocols = nCodes = 0;
+  rejected = 0;
+}
+
+byte RadioSniff::getProtocols() {
+  return( nProtocols );
+}
+
+const SniffProtocol &RadioSniff::getProtocol(byte i) {
+  return( protocol[i] );
+}
+
+byte RadioSniff::getCodes() {
+  return( nCodes );
+}
+
+const SniffCode &RadioSniff::getCode(byte i) {
+  return( code[i] );
+}
+
+unsigned int RadioSniff::getRejected() {
+  return( rejected );
+}
+
+int RadioSniff::reject() {
+  rejected++;
+  return( -1 );
+}
+
+// x in pulses of unit, rounded; 0 means it's too long to say
+static byte pulses(unsigned long x, unsigned long unit) {
+  unsigned long n = (x + unit / 2) / unit;
+  return( n > 255 ? 0 : n );
+}
+
+// a and b within 25% of a
+static boolean near(unsigned long a, unsigned long b) {
+  unsigned long d = a > b ? a - b : b - a;
+  return( d <= a / 4 );
+}
+
+// the cluster of times x belongs to: the nearest mean.  with tol, only one within 25%; -1 if none.
+static int nearest(unsigned int x, const unsigned long *sum, const byte *cnt, byte nc, boolean tol) {
+  int best = -1;
+  unsigned long bestD = 0;
+  for (byte c = 0; c < nc; c++) {
+    unsigned long mean = sum[c] / cnt[c];
+    unsigned long d = x > mean ? x - mean : mean - x;
+    if ( tol && d > mean / 4 ) continue;
+    if ( best < 0 || d < bestD ) {
+      best = c;
+      bestD = d;
+    }
+  }
+  return( best );
+}
+
+boolean RadioSniff::decode(const unsigned int *e, byte n, SniffProtocol &p, unsigned long &val) {
+  // gap, HIGH/LOW for each bit, trailing HIGH, gap
+  if ( n < 2 * SNIFF_MIN_BITS + 3 || (n & 1) == 0 ) return( false );
+  byte bits = (n - 3) / 2;
+  if ( bits > SNIFF_MAX_BITS ) return( false );
+
+  // cluster the bits' HIGH times ([0]) and LOW times ([1])
+  unsigned long sum[2][SNIFF_CLUSTERS];
+  byte cnt[2][SNIFF_CLUSTERS];
+  byte nc[2] = { 0, 0 };
+  unsigned long total = 0;
+  for (byte i = 1; i < n - 2; i++) {
+    byte k = (i & 1) ? 0 : 1;
+    int c = nearest(e[i], sum[k], cnt[k], nc[k], true);
+    if ( c < 0 ) {
+      if ( nc[k] == SNIFF_CLUSTERS ) return( false );
+      c = nc[k]++;
+      sum[k][c] = cnt[k][c] = 0;
+    }
+    sum[k][c] += e[i];
+    cnt[k][c]++;
+    total += e[i];
+  }
+
+  // the pulse length: the shortest cluster, then refined over every time in the frame
+  unsigned long unit = 0xFFFFFFFFUL;
+  for (byte k = 0; k < 2; k++) {
+    for (byte c = 0; c < nc[k]; c++) {
+      if ( sum[k][c] / cnt[k][c] < unit ) unit = sum[k][c] / cnt[k][c];
+    }
+  }
+  if ( unit == 0 ) return( false );
+  unsigned long units = 0;
+  for (byte i = 1; i < n - 2; i++) units += pulses(e[i], unit);
+  if ( units == 0 ) return( false );
+  unit = total / units;
+
+  // each bit is a (HIGH, LOW) pair of clusters, and there have to be two kinds
+  byte sym[2];
+  byte nSym = 0;
+  val = 0;
+  for (byte b = 0; b < bits; b++) {
+    byte s = nearest(e[2 * b + 1], sum[0], cnt[0], nc[0], false) << 4 |
+             nearest(e[2 * b + 2], sum[1], cnt[1], nc[1], false);
+    byte j = 0;
+    while ( j < nSym && sym[j] != s ) j++;
+    if ( j == nSym ) {
+      if ( nSym == 2 ) return( false );
+      sym[nSym++] = s;
+    }
+    val = (val << 1) | j;
+  }
+  if ( nSym < 2 ) return( false );
+
+  // which one is the "one": the longer HIGH, or with HIGHs alike, the longer LOW
+  byte seq[2][2];
+  for (byte j = 0; j < 2; j++) {
+    seq[j][0] = pulses(sum[0][sym[j] >> 4] / cnt[0][sym[j] >> 4], unit);
+    seq[j][1] = pulses(sum[1][sym[j] & 15] / cnt[1][sym[j] & 15], unit);
+    if ( seq[j][0] == 0 || seq[j][1] == 0 ) return( false );
+  }
+  byte one;
+  if ( seq[0][0] != seq[1][0] ) one = seq[1][0] > seq[0][0];
+  else if ( seq[0][1] != seq[1][1] ) one = seq[1][1] > seq[0][1];
+  else return( false );
+  if ( one == 0 ) val = ~val;
+  if ( bits < 32 ) val &= (1UL << bits) - 1;
+
+  p.pulseLength = unit;
+  p.bits = bits;
+  p.sync[0] = pulses(e[n - 2], unit);
+  p.sync[1] = pulses(e[0], unit);
+  p.zero[0] = seq[!one][0];
+  p.zero[1] = seq[!one][1];
+  p.one[0] = seq[one][0];
+  p.one[1] = seq[one][1];
+  p.frames = 1;
+  return( p.sync[0] > 0 && p.sync[1] > 0 );
+}
+
+int RadioSniff::add(const unsigned int *edges, byte n) {
+  SniffProtocol p;
+  unsigned long val;
+  if ( !decode(edges, n, p, val) ) return( reject() );
+
+  // one we've seen?  same shape, and near enough in time
+  byte i;
+  for (i = 0; i < nProtocols; i++) {
+    SniffProtocol &q = protocol[i];
+    if ( q.bits == p.bits && q.zero[0] == p.zero[0] && q.zero[1] == p.zero[1] &&
+         q.one[0] == p.one[0] && q.one[1] == p.one[1] &&
+         near(q.sync[1], p.sync[1]) && near(q.pulseLength, p.pulseLength) ) break;
+  }
+  if ( i == nProtocols ) {
+    if ( nProtocols == SNIFF_PROTOCOLS ) return( reject() );
+    protocol[nProtocols++] = p;
+  } else {
+    SniffProtocol &q = protocol[i];
+    // running mean over the first 16 frames, then a moving one
+    long step = ((long)p.pulseLength - (long)q.pulseLength) / (q.frames < 16 ? q.frames + 1 : 16);
+    q.pulseLength += step;
+    if ( q.frames < 255 ) q.frames++;
+  }
+
+  for (byte c = 0; c < nCodes; c++) {
+    if ( code[c].code == val && code[c].protocol == i ) {
+      if ( code[c].count < 255 ) code[c].count++;
+      return( c );
+    }
+  }
+  if ( nCodes == SNIFF_CODES ) return( -1 );
+  code[nCodes].code = val;
+  code[nCodes].protocol = i;
+  code[nCodes].count = 1;
+  return( nCodes++ );
+}
@@ -0,0 +1,84 @@
+#ifndef RadioSniff_h
+#define RadioSniff_h
+
+/*
+RadioSniff: learn an unknown 433 MHz OOK protocol from raw edge timings.
+
+Give it one captured frame at a time: the LOW gap ahead of it, then the
+HIGH and LOW times of each bit, the trailing HIGH and the LOW gap after it,
+in us.  It clusters the HIGH times and the LOW times, takes the shortest
+cluster as the pulse length, and expects exactly two (HIGH, LOW) symbols.
+Of the two, "one" is the longer HIGH (pulse width, like the Etekcity
+outlets) or, with equal HIGHs, the longer LOW (pulse distance, like the
+TB304BC sensors).  The result is in the same terms as RadioProtocol in
+libraries/RadioRx/RadioRx.h (see RADIO_TB304BC and RADIO_ETEK there): pulse
+length, bit count, and sync/zero/one as {HIGH, LOW} in pulses.  Frames that agree on all that are one protocol;
+the distinct codes seen under each are counted.
+
+Fixed memory: SNIFF_PROTOCOLS descriptors and SNIFF_CODES codes.  Plain
+C++ apart from the Arduino types, so tools/radiosniff builds it on a host.
+
+  RadioSniff sniffer;
+  int c = sniffer.add(edges, n);
+  if ( c >= 0 ) print(sniffer.getProtocol(sniffer.getCode(c).protocol), sniffer.getCode(c));
+*/
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include <stdint.h>
+typedef uint8_t byte;
+typedef bool boolean;
+#endif
+
+#define SNIFF_PROTOCOLS 2   // descriptors kept
+#define SNIFF_CODES 8       // distinct codes kept, over all protocols
+#define SNIFF_CLUSTERS 4    // HIGH or LOW time clusters in a frame; more is noise
+#define SNIFF_MIN_BITS 8    // shorter frames are noise
+#define SNIFF_MAX_BITS 32   // the width of a code
+
+// a protocol, as found in the frames.  sequences are {HIGH, LOW}, in pulses.
+typedef struct {
+  unsigned int pulseLength; // us, averaged over the frames
+  byte bits;
+  byte sync[2];
+  byte zero[2];
+  byte one[2];
+  byte frames;              // frames seen, up to 255
+} SniffProtocol;
+
+typedef struct {
+  unsigned long code;
+  byte protocol;            // index for getProtocol()
+  byte count;               // times seen, up to 255
+} SniffCode;
+
+class RadioSniff {
+  public:
+    RadioSniff();
+
+    // analyze one capture of n edges, as above.  returns the index of its code for getCode(),
+    // or -1 if it isn't a frame of two symbols, or there's no room left to keep it.
+    int add(const unsigned int *edges, byte n);
+
+    byte getProtocols();
+    const SniffProtocol &getProtocol(byte i);
+    byte getCodes();
+    const SniffCode &getCode(byte i);
+    // captures that weren't frames
+    unsigned int getRejected();
+
+    // forget everything
+    void clear();
+
+  private:
+    SniffProtocol protocol[SNIFF_PROTOCOLS];
+    SniffCode code[SNIFF_CODES];
+    byte nProtocols, nCodes;
+    unsigned int rejected;
+
+    boolean decode(const unsigned int *edges, byte n, SniffProtocol &p, unsigned long &val);
+    int reject();
+};
+
+#endif
@@ -0,0 +1,100 @@
+#include <Arduino.h>
+#include "SensorStats.h"
+
+SensorStats::SensorStats(uint8_t emaShift) {
+  this->emaShift = emaShift;
+  reset();
+}
+
+void SensorStats::reset() {
+  head = n = 0;
+  sum = minVal = maxVal = 0;
+  emaFixed = var = 0;
+  reported = 0;
+}
+
+void SensorStats::update(long value) {
+  // window: drop the oldest sample once full
+  long evicted = window[head];
+  window[head] = value;
+  head = (head + 1) % STATS_WINDOW;
+
+  if ( n < STATS_WINDOW ) {
+    n++;
+    sum += value;
+  } else {
+    sum += value - evicted;
+  }
+
+  if ( n == 1 ) {
+    // first sample seeds everything, so the EMA doesn't ramp up from zero
+    minVal = maxVal = value;
+    emaFixed = value * (1L << STATS_FRAC_BITS);
+    var = 0;
+    return;
+  }
+
+  // only rescan the window when the sample leaving it was an extreme
+  if ( n == STATS_WINDOW && (evicted == minVal || evicted == maxVal) ) {
+    rescan();
+  } else {
+    if ( value < minVal ) minVal = value;
+    if ( value > maxVal ) maxVal = value;
+  }
+
+  // EMA: ema += (x - ema) / 2^shift
+  // a multiply, not a shift: value can be negative, and shifting that left is undefined
+  emaFixed += (value * (1L << STATS_FRAC_BITS) - emaFixed) >> emaShift;
+
+  // variance: var += (dev^2 - var) / 2^shift.  clamp dev so dev^2 fits a long.
+  long dev = value - getEMA();
+  dev = constrain(dev, -32767L, 32767L);
+  var += (dev * dev - var) >> emaShift;
+}
+
+void SensorStats::rescan() {
+  minVal = maxVal = window[0];
+  for ( uint8_t i = 1; i < n; i++ ) {
+    if ( window[i] < minVal ) minVal = window[i];
+    if ( window[i] > maxVal ) maxVal = window[i];
+  }
+}
+
+long SensorStats::getLast() {
+  return ( window[(head + STATS_WINDOW - 1) % STATS_WINDOW] );
+}
+
+long SensorStats::getEMA() {
+  // round to nearest
+  return ( (emaFixed + (1L << (STATS_FRAC_BITS - 1))) >> STATS_FRAC_BITS );
+}
+
+long SensorStats::getMin() {
+  return ( minVal );
+}
+
+long SensorStats::getMax() {
+  return ( maxVal );
+}
+
+long SensorStats::getMean() {
+  if ( n == 0 ) return ( 0 );
+  return ( sum / n );
+}
+
+unsigned long SensorStats::getVariance() {
+  return ( var );
+}
+
+uint8_t SensorStats::getCount() {
+  return ( n );
+}
+
+boolean SensorStats::changed(long deadband) {
+  long now = getEMA();
+  if ( abs(now - reported) > deadband ) {
+    reported = now;
+    return ( true );
+  }
+  return ( false );
+}
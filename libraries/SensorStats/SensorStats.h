@@ -0,0 +1,56 @@
+#ifndef SensorStats_h
+#define SensorStats_h
+
+/*
+SensorStats: fixed-memory running statistics for one sensor channel.
+
+Keeps the last STATS_WINDOW samples for windowed min/max/mean, plus an
+exponential moving average and a variance estimate around it.  Integer
+math only; the EMA carries STATS_FRAC_BITS of fraction.
+
+  SensorStats moist(3); // EMA weight 1/8
+  moist.update(analogRead(pin));
+  if( moist.changed(5) ) redraw(moist.getEMA());
+*/
+
+#include <Arduino.h>
+
+#define STATS_WINDOW 8     // samples kept for min/max/mean
+#define STATS_FRAC_BITS 4  // fixed-point fraction bits for the EMA
+
+class SensorStats {
+  public:
+    // EMA weight is 1/2^emaShift.  0 tracks the raw value.
+    SensorStats(uint8_t emaShift = 2);
+
+    // add a sample.  constant time, unless the sample leaving the window was its min or
+    // max: then the window is rescanned, STATS_WINDOW samples.
+    void update(long value);
+    // forget all samples
+    void reset();
+
+    // accessor functions
+    long getLast();         // most recent sample
+    long getEMA();          // exponential moving average, rounded
+    long getMin();          // smallest sample in the window
+    long getMax();          // largest sample in the window
+    long getMean();         // window average, rounded toward zero
+    unsigned long getVariance(); // exponentially weighted variance about the EMA
+    uint8_t getCount();     // samples in the window, up to STATS_WINDOW
+
+    // true if the EMA moved more than deadband since the last time this returned true.
+    // use it to gate redraws and reports on real change, not one-count jitter.
+    boolean changed(long deadband);
+
+  private:
+    long window[STATS_WINDOW];
+    uint8_t head, n, emaShift;
+    long sum, minVal, maxVal;
+    long emaFixed;        // EMA * 2^STATS_FRAC_BITS
+    long var;             // variance, in units squared
+    long reported;        // EMA the last time changed() returned true
+
+    void rescan();
+};
+
+#endif
@@ -45,6 +45,10 @@ TSL2561::TSL2561(uint8_t addr) {
   _initialized = false;
   _integration = TSL2561_INTEGRATIONTIME_13MS;
   _gain = TSL2561_GAIN_16X;
+  _autoRange = false;
+  _integrating = false;
+  _timingChanged = false;
+  _range = 3; // 13ms, 16x
 
   // we cant do wire initialization till later, because we havent loaded Wire yet
 }
@@ -119,6 +123,30 @@ void TSL2561::setTiming(tsl2561IntegrationTime_t integration)
   disable();
 }
 
+// piecewise-linear lux coefficients, one row per channel ratio bracket:
+// ratio ceiling K, intercept B and slope M (see datasheet)
+static const tsl2561LuxBracket_t luxTable[TSL2561_LUX_BRACKETS] PROGMEM = {
+#ifdef TSL2561_PACKAGE_CS
+  { TSL2561_LUX_K1C, TSL2561_LUX_B1C, TSL2561_LUX_M1C },
+  { TSL2561_LUX_K2C, TSL2561_LUX_B2C, TSL2561_LUX_M2C },
+  { TSL2561_LUX_K3C, TSL2561_LUX_B3C, TSL2561_LUX_M3C },
+  { TSL2561_LUX_K4C, TSL2561_LUX_B4C, TSL2561_LUX_M4C },
+  { TSL2561_LUX_K5C, TSL2561_LUX_B5C, TSL2561_LUX_M5C },
+  { TSL2561_LUX_K6C, TSL2561_LUX_B6C, TSL2561_LUX_M6C },
+  { TSL2561_LUX_K7C, TSL2561_LUX_B7C, TSL2561_LUX_M7C },
+  { TSL2561_LUX_K8C, TSL2561_LUX_B8C, TSL2561_LUX_M8C }
+#else
+  { TSL2561_LUX_K1T, TSL2561_LUX_B1T, TSL2561_LUX_M1T },
+  { TSL2561_LUX_K2T, TSL2561_LUX_B2T, TSL2561_LUX_M2T },
+  { TSL2561_LUX_K3T, TSL2561_LUX_B3T, TSL2561_LUX_M3T },
+  { TSL2561_LUX_K4T, TSL2561_LUX_B4T, TSL2561_LUX_M4T },
+  { TSL2561_LUX_K5T, TSL2561_LUX_B5T, TSL2561_LUX_M5T },
+  { TSL2561_LUX_K6T, TSL2561_LUX_B6T, TSL2561_LUX_M6T },
+  { TSL2561_LUX_K7T, TSL2561_LUX_B7T, TSL2561_LUX_M7T },
+  { TSL2561_LUX_K8T, TSL2561_LUX_B8T, TSL2561_LUX_M8T }
+#endif
+};
+
 uint32_t TSL2561::calculateLux(uint16_t ch0, uint16_t ch1)
 {
   unsigned long chScale;
@@ -152,43 +180,11 @@ uint32_t TSL2561::calculateLux(uint16_t ch0, uint16_t ch1)
   // round the ratio value
   unsigned long ratio = (ratio1 + 1) >> 1;
 
-  unsigned int b, m;
-
-#ifdef TSL2561_PACKAGE_CS
-  if ((ratio >= 0) && (ratio <= TSL2561_LUX_K1C))
-    {b=TSL2561_LUX_B1C; m=TSL2561_LUX_M1C;}
-  else if (ratio <= TSL2561_LUX_K2C)
-    {b=TSL2561_LUX_B2C; m=TSL2561_LUX_M2C;}
-  else if (ratio <= TSL2561_LUX_K3C)
-    {b=TSL2561_LUX_B3C; m=TSL2561_LUX_M3C;}
-  else if (ratio <= TSL2561_LUX_K4C)
-    {b=TSL2561_LUX_B4C; m=TSL2561_LUX_M4C;}
-  else if (ratio <= TSL2561_LUX_K5C)
-    {b=TSL2561_LUX_B5C; m=TSL2561_LUX_M5C;}
-  else if (ratio <= TSL2561_LUX_K6C)
-    {b=TSL2561_LUX_B6C; m=TSL2561_LUX_M6C;}
-  else if (ratio <= TSL2561_LUX_K7C)
-    {b=TSL2561_LUX_B7C; m=TSL2561_LUX_M7C;}
-  else if (ratio > TSL2561_LUX_K8C)
-    {b=TSL2561_LUX_B8C; m=TSL2561_LUX_M8C;}
-#else
-  if ((ratio >= 0) && (ratio <= TSL2561_LUX_K1T))
-    {b=TSL2561_LUX_B1T; m=TSL2561_LUX_M1T;}
-  else if (ratio <= TSL2561_LUX_K2T)
-    {b=TSL2561_LUX_B2T; m=TSL2561_LUX_M2T;}
-  else if (ratio <= TSL2561_LUX_K3T)
-    {b=TSL2561_LUX_B3T; m=TSL2561_LUX_M3T;}
-  else if (ratio <= TSL2561_LUX_K4T)
-    {b=TSL2561_LUX_B4T; m=TSL2561_LUX_M4T;}
-  else if (ratio <= TSL2561_LUX_K5T)
-    {b=TSL2561_LUX_B5T; m=TSL2561_LUX_M5T;}
-  else if (ratio <= TSL2561_LUX_K6T)
-    {b=TSL2561_LUX_B6T; m=TSL2561_LUX_M6T;}
-  else if (ratio <= TSL2561_LUX_K7T)
-    {b=TSL2561_LUX_B7T; m=TSL2561_LUX_M7T;}
-  else if (ratio > TSL2561_LUX_K8T)
-    {b=TSL2561_LUX_B8T; m=TSL2561_LUX_M8T;}
-#endif
+  // find the bracket the ratio falls in; the last one applies above K7
+  uint8_t i = 0;
+  while ((i < TSL2561_LUX_BRACKETS - 1) && (ratio > pgm_read_word(&luxTable[i].k))) i++;
+  unsigned int b = pgm_read_word(&luxTable[i].b);
+  unsigned int m = pgm_read_word(&luxTable[i].m);
 
   unsigned long temp;
   temp = ((channel0 * b) - (channel1 * m));
@@ -214,18 +210,7 @@ uint32_t TSL2561::getFullLuminosity (void)
   enable();
 
   // Wait x ms for ADC to complete
-  switch (_integration)
-  {
-    case TSL2561_INTEGRATIONTIME_13MS:
-      delay(14);
-      break;
-    case TSL2561_INTEGRATIONTIME_101MS:
-      delay(102);
-      break;
-    default:
-      delay(403);
-      break;
-  }
+  delay(integrationDelay());
 
   uint32_t x;
   x = read16(TSL2561_COMMAND_BIT | TSL2561_WORD_BIT | TSL2561_REGISTER_CHAN1_LOW);
@@ -295,3 +280,136 @@ void TSL2561::write8 (uint8_t reg, uint8_t value)
 #endif
   Wire.endTransmission();
 }
+
+// ms to wait for the ADC to complete at the current integration time
+uint16_t TSL2561::integrationDelay(void)
+{
+  switch (_integration)
+  {
+    case TSL2561_INTEGRATIONTIME_13MS:
+      return 14;
+    case TSL2561_INTEGRATIONTIME_101MS:
+      return 102;
+    default:
+      return 403;
+  }
+}
+
+// gain and integration time for each auto-range step, most sensitive first
+static const uint8_t rangeTiming[TSL2561_RANGE_STEPS] PROGMEM = {
+  TSL2561_INTEGRATIONTIME_402MS | TSL2561_GAIN_16X,
+  TSL2561_INTEGRATIONTIME_101MS | TSL2561_GAIN_16X,
+  TSL2561_INTEGRATIONTIME_402MS | TSL2561_GAIN_0X,
+  TSL2561_INTEGRATIONTIME_13MS  | TSL2561_GAIN_16X,
+  TSL2561_INTEGRATIONTIME_101MS | TSL2561_GAIN_0X,
+  TSL2561_INTEGRATIONTIME_13MS  | TSL2561_GAIN_0X
+};
+
+void TSL2561::setAutoRange(boolean enable)
+{
+  _autoRange = enable;
+  if (!enable) return;
+
+  // start the ladder at the step matching the current settings
+  for (uint8_t r = 0; r < TSL2561_RANGE_STEPS; r++) {
+    if (pgm_read_byte(&rangeTiming[r]) == (_integration | _gain)) _range = r;
+  }
+}
+
+// power up and let the ADC integrate; returns immediately
+void TSL2561::startIntegration(void)
+{
+  enable();
+  // timing picked by the last auto-range takes effect with this cycle
+  if (_timingChanged) {
+    write8(TSL2561_COMMAND_BIT | TSL2561_REGISTER_TIMING, _integration | _gain);
+    _timingChanged = false;
+  }
+  _integrationStart = millis();
+  _integrating = true;
+}
+
+boolean TSL2561::isIntegrating(void)
+{
+  return _integrating;
+}
+
+// true once an integration started with startIntegration() has completed
+boolean TSL2561::integrationReady(void)
+{
+  return _integrating && (millis() - _integrationStart >= integrationDelay());
+}
+
+// read both channels and power down.  lux is computed with the settings the
+// reading was taken at.  returns false if a channel saturated and the next
+// cycle will use a less sensitive range; the lux value is only a lower bound.
+boolean TSL2561::collectLuminosity(uint16_t &broadband, uint16_t &ir, uint32_t &lux)
+{
+  broadband = read16(TSL2561_COMMAND_BIT | TSL2561_WORD_BIT | TSL2561_REGISTER_CHAN0_LOW);
+  ir = read16(TSL2561_COMMAND_BIT | TSL2561_WORD_BIT | TSL2561_REGISTER_CHAN1_LOW);
+  disable();
+  _integrating = false;
+
+  lux = calculateLux(broadband, ir);
+
+  uint16_t clip;
+  switch (_integration)
+  {
+    case TSL2561_INTEGRATIONTIME_13MS:
+      clip = TSL2561_CLIPPING_13MS;
+      break;
+    case TSL2561_INTEGRATIONTIME_101MS:
+      clip = TSL2561_CLIPPING_101MS;
+      break;
+    default:
+      clip = TSL2561_CLIPPING_402MS;
+      break;
+  }
+  boolean saturated = (broadband > clip || ir > clip);
+
+  uint8_t lastRange = _range;
+  if (_autoRange) autoRange(broadband, ir);
+
+  return !(saturated && _range != lastRange);
+}
+
+// move one step along the ladder if the counts are outside the thresholds
+void TSL2561::autoRange(uint16_t broadband, uint16_t ir)
+{
+  uint16_t hi, lo;
+
+  switch (_integration)
+  {
+    case TSL2561_INTEGRATIONTIME_13MS:
+      hi = TSL2561_AGC_THI_13MS;
+      lo = TSL2561_AGC_TLO_13MS;
+      break;
+    case TSL2561_INTEGRATIONTIME_101MS:
+      hi = TSL2561_AGC_THI_101MS;
+      lo = TSL2561_AGC_TLO_101MS;
+      break;
+    default:
+      hi = TSL2561_AGC_THI_402MS;
+      lo = TSL2561_AGC_TLO_402MS;
+      break;
+  }
+
+  if ((broadband > hi || ir > hi) && _range < TSL2561_RANGE_STEPS - 1) _range++;
+  else if (broadband < lo && _range > 0) _range--;
+  else return;
+
+  uint8_t timing = pgm_read_byte(&rangeTiming[_range]);
+  _integration = (tsl2561IntegrationTime_t)(timing & 0x03);
+  _gain = (tsl2561Gain_t)(timing & 0x10);
+  _timingChanged = true;
+}
+
+tsl2561IntegrationTime_t TSL2561::getTiming(void)
+{
+  return _integration;
+}
+
+tsl2561Gain_t TSL2561::getGain(void)
+{
+  return _gain;
+}
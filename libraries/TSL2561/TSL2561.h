@@ -126,6 +126,32 @@
 #define TSL2561_LUX_B8C           (0x0000)  // 0.000 * 2^LUX_SCALE
 #define TSL2561_LUX_M8C           (0x0000)  // 0.000 * 2^LUX_SCALE
 
+// Auto-range thresholds (channel counts) for each integration time.
+// Above HI the next cycle drops sensitivity, below LO it raises it.
+// 13ms and 101ms top out below 65535 (5047 and 37177 counts)
+#define TSL2561_AGC_THI_13MS      (4850)
+#define TSL2561_AGC_TLO_13MS      (100)
+#define TSL2561_AGC_THI_101MS     (36000)
+#define TSL2561_AGC_TLO_101MS     (200)
+#define TSL2561_AGC_THI_402MS     (63000)
+#define TSL2561_AGC_TLO_402MS     (500)
+#define TSL2561_CLIPPING_13MS     (4900)
+#define TSL2561_CLIPPING_101MS    (37000)
+#define TSL2561_CLIPPING_402MS    (65000)
+
+// Number of gain/integration steps the auto-range walks through
+#define TSL2561_RANGE_STEPS       (6)
+
+// one row of the lux breakpoint table used by calculateLux()
+#define TSL2561_LUX_BRACKETS      (8)
+typedef struct
+{
+  uint16_t k;    // upper channel ratio for this bracket
+  uint16_t b;    // channel 0 coefficient
+  uint16_t m;    // channel 1 coefficient
+}
+tsl2561LuxBracket_t;
+
 enum
 {
   TSL2561_REGISTER_CONTROL          = 0x00,
@@ -169,16 +195,33 @@ class TSL2561 {
   uint16_t read16(uint8_t reg);
 
   uint32_t calculateLux(uint16_t ch0, uint16_t ch1);
+  tsl2561IntegrationTime_t getTiming(void);
+  tsl2561Gain_t getGain(void);
   void setTiming(tsl2561IntegrationTime_t integration);
   void setGain(tsl2561Gain_t gain);
   uint16_t getLuminosity (uint8_t channel);
   uint32_t getFullLuminosity ();
 
+  // Non-blocking integration cycle: start, poll, collect.
+  // With auto-range on, each collect picks the gain and integration
+  // time for the next cycle from the counts it just read.
+  void setAutoRange(boolean enable);
+  void startIntegration(void);
+  boolean isIntegrating(void);
+  boolean integrationReady(void);
+  boolean collectLuminosity(uint16_t &broadband, uint16_t &ir, uint32_t &lux);
+
  private:
   int8_t _addr;
   tsl2561IntegrationTime_t _integration;
   tsl2561Gain_t _gain;
 
   boolean _initialized;
+
+  boolean _autoRange, _integrating, _timingChanged;
+  uint8_t _range;
+  unsigned long _integrationStart;
+  uint16_t integrationDelay(void);
+  void autoRange(uint16_t broadband, uint16_t ir);
 };
 #endif
@@ -0,0 +1,114 @@
+#include <Wire.h>
+#include "TSL2561.h"
+
+// Checks the table-driven TSL2561::calculateLux() against the original
+// if/else bracket version and times both.  No sensor needs to be attached:
+// only the gain and integration settings are used.  tools/luxcheck runs the
+// same comparison on a host, over every (ch0, ch1) pair.
+
+TSL2561 tsl(TSL2561_ADDR_FLOAT);
+
+// the original calculateLux(), T/FN/CL package, kept here as the reference
+uint32_t referenceLux(uint16_t ch0, uint16_t ch1, tsl2561IntegrationTime_t integration, tsl2561Gain_t gain)
+{
+  unsigned long chScale;
+  unsigned long channel1;
+  unsigned long channel0;
+
+  switch (integration)
+  {
+    case TSL2561_INTEGRATIONTIME_13MS:
+      chScale = TSL2561_LUX_CHSCALE_TINT0;
+      break;
+    case TSL2561_INTEGRATIONTIME_101MS:
+      chScale = TSL2561_LUX_CHSCALE_TINT1;
+      break;
+    default:
+      chScale = (1 << TSL2561_LUX_CHSCALE);
+      break;
+  }
+  if (!gain) chScale = chScale << 4;
+
+  channel0 = (ch0 * chScale) >> TSL2561_LUX_CHSCALE;
+  channel1 = (ch1 * chScale) >> TSL2561_LUX_CHSCALE;
+
+  unsigned long ratio1 = 0;
+  if (channel0 != 0) ratio1 = (channel1 << (TSL2561_LUX_RATIOSCALE+1)) / channel0;
+  unsigned long ratio = (ratio1 + 1) >> 1;
+
+  unsigned int b, m;
+  if ((ratio >= 0) && (ratio <= TSL2561_LUX_K1T))
+    {b=TSL2561_LUX_B1T; m=TSL2561_LUX_M1T;}
+  else if (ratio <= TSL2561_LUX_K2T)
+    {b=TSL2561_LUX_B2T; m=TSL2561_LUX_M2T;}
+  else if (ratio <= TSL2561_LUX_K3T)
+    {b=TSL2561_LUX_B3T; m=TSL2561_LUX_M3T;}
+  else if (ratio <= TSL2561_LUX_K4T)
+    {b=TSL2561_LUX_B4T; m=TSL2561_LUX_M4T;}
+  else if (ratio <= TSL2561_LUX_K5T)
+    {b=TSL2561_LUX_B5T; m=TSL2561_LUX_M5T;}
+  else if (ratio <= TSL2561_LUX_K6T)
+    {b=TSL2561_LUX_B6T; m=TSL2561_LUX_M6T;}
+  else if (ratio <= TSL2561_LUX_K7T)
+    {b=TSL2561_LUX_B7T; m=TSL2561_LUX_M7T;}
+  else
+    {b=TSL2561_LUX_B8T; m=TSL2561_LUX_M8T;}
+
+  unsigned long temp = ((channel0 * b) - (channel1 * m));
+  temp += (1 << (TSL2561_LUX_LUXSCALE-1));
+  return temp >> TSL2561_LUX_LUXSCALE;
+}
+
+const tsl2561IntegrationTime_t timings[3] = {
+  TSL2561_INTEGRATIONTIME_13MS, TSL2561_INTEGRATIONTIME_101MS, TSL2561_INTEGRATIONTIME_402MS
+};
+const tsl2561Gain_t gains[2] = { TSL2561_GAIN_0X, TSL2561_GAIN_16X };
+
+void setup(void) {
+  Serial.begin(115200);
+  Serial.println("calculateLux() check and benchmark");
+
+  unsigned long checked = 0, mismatches = 0;
+  unsigned long tableTime = 0, referenceTime = 0;
+  volatile uint32_t sink;
+
+  for (byte t = 0; t < 3; t++) {
+    for (byte g = 0; g < 2; g++) {
+      tsl.setTiming(timings[t]);
+      tsl.setGain(gains[g]);
+
+      // a coarse grid over both channels.  ch1 runs to twice ch0, so ratios
+      // past 1.3 (the last bracket, where lux is 0) are compared too
+      for (unsigned long ch0 = 1; ch0 < 65536UL; ch0 += 1021) {
+        for (unsigned long ch1 = 0; ch1 <= 2 * ch0 && ch1 < 65536UL; ch1 += 1 + ch0 / 64) {
+          unsigned long tic = micros();
+          uint32_t a = tsl.calculateLux(ch0, ch1);
+          unsigned long toc = micros();
+          uint32_t b = referenceLux(ch0, ch1, timings[t], gains[g]);
+          unsigned long tac = micros();
+
+          tableTime += toc - tic;
+          referenceTime += tac - toc;
+          sink = a;
+          checked++;
+          if (a != b) {
+            mismatches++;
+            Serial.print("Mismatch ch0="); Serial.print(ch0);
+            Serial.print(" ch1="); Serial.print(ch1);
+            Serial.print(" table="); Serial.print(a);
+            Serial.print(" reference="); Serial.println(b);
+          }
+        }
+      }
+    }
+  }
+
+  Serial.print("Checked: "); Serial.print(checked);
+  Serial.print(" Mismatches: "); Serial.println(mismatches);
+  // micros() has 4us resolution on a 16MHz AVR; the totals average that out
+  Serial.print("Table: ");     Serial.print(float(tableTime) / checked * 16.0);     Serial.println(" cycles/call");
+  Serial.print("Reference: "); Serial.print(float(referenceTime) / checked * 16.0); Serial.println(" cycles/call");
+}
+
+void loop(void) {
+}
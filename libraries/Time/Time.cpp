@@ -31,14 +31,22 @@
 
 static tmElements_t tm;          // a cache of time elements
 static time_t       cacheTime;   // the time the cache was updated
+static uint8_t      cacheValid = false;
 static time_t       syncInterval = 300;  // time sync will be attempted after this many seconds
 
+static void advanceCache(unsigned long delta);
+
 void refreshCache( time_t t){
-  if( t != cacheTime)
-  {
+  if( cacheValid && t == cacheTime)
+    return;
+  // the clock mostly moves forward a little at a time; carry that into the cached fields
+  // rather than redoing the year and month loops in breakTime()
+  if( cacheValid && t > cacheTime && t - cacheTime < SECS_PER_DAY)
+    advanceCache(t - cacheTime);
+  else
     breakTime(t, tm); 
-    cacheTime = t; 
-  }
+  cacheTime = t; 
+  cacheValid = true;
 }
 
 int hour() { // the hour now 
@@ -194,6 +202,37 @@ void breakTime(time_t time, tmElements_t &tm){
   tm.Day = time + 1;     // day of month
 }
 
+// move the cache forward by less than a day, so at most one day carries
+static void advanceCache(unsigned long delta){
+  if( delta < 60UL - tm.Second) {  // the usual case: same minute
+    tm.Second += delta;
+    return;
+  }
+  delta += tm.Second;
+  tm.Second = delta % 60;
+  delta = delta / 60 + tm.Minute;  // now it is minutes
+  tm.Minute = delta % 60;
+  delta = delta / 60 + tm.Hour;    // now it is hours
+  tm.Hour = delta % 24;
+  if( delta < 24)
+    return;
+  
+  // next day
+  uint8_t monthLength;
+  tm.Wday = tm.Wday % 7 + 1;
+  if( tm.Month == 2 && LEAP_YEAR(tm.Year))
+    monthLength = 29;
+  else
+    monthLength = monthDays[tm.Month-1];
+  if( ++tm.Day > monthLength) {
+    tm.Day = 1;
+    if( ++tm.Month > 12) {
+      tm.Month = 1;
+      tm.Year++;
+    }
+  }
+}
+
 time_t makeTime(tmElements_t &tm){   
 // assemble time elements into time_t 
 // note year argument is offset from 1970 (see macros in time.h to convert to other formats)
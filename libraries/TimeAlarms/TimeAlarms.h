@@ -7,7 +7,12 @@
 
 #include "Time.h"
 
-#define dtNBR_ALARMS 6   // max is 255
+// to change it, pass it to the compiler for the whole build (-DdtNBR_ALARMS=10, e.g. in
+// compiler.cpp.extra_flags).  a #define in the sketch doesn't reach TimeAlarms.cpp, which
+// would then build TimeAlarmsClass with a different number of slots from the sketch's.
+#ifndef dtNBR_ALARMS
+#define dtNBR_ALARMS 6   // max is 255. each slot is 13 bytes of RAM: 11 for the alarm, 2 for its place in the queue
+#endif
 
 #define USE_SPECIALIST_METHODS  // define this for testing
 
@@ -32,6 +37,7 @@ typedef AlarmID_t AlarmId;  // Arduino friendly name
 
 #define dtINVALID_ALARM_ID 255
 #define dtINVALID_TIME     0L
+#define dtNOT_QUEUED       255
 
 class AlarmClass;  // forward reference
 typedef void (*OnTick_t)();  // alarm callback function typedef 
@@ -55,6 +61,14 @@ class TimeAlarmsClass
 {
 private:
    AlarmClass Alarm[dtNBR_ALARMS];
+   AlarmID_t heap[dtNBR_ALARMS];     // enabled alarm ids, min-heap on nextTrigger
+   uint8_t heapPos[dtNBR_ALARMS];    // index of each id in heap, or dtNOT_QUEUED
+   uint8_t heapSize;
+   void heapSwap(uint8_t a, uint8_t b);
+   void siftUp(uint8_t i);
+   void siftDown(uint8_t i);
+   void dequeue(AlarmID_t ID);
+   void requeue(AlarmID_t ID);       // call after an alarm's nextTrigger or isEnabled changes
    void serviceAlarms();
    uint8_t isServicing;
    uint8_t servicedAlarmId; // the alarm currently being serviced
@@ -100,7 +114,7 @@ private:  // the following methods are for testing and are not documented as par
 #endif
   void free(AlarmID_t ID);                  // free the id to allow its reuse 
   uint8_t count();                          // returns the number of allocated timers
-  time_t getNextTrigger();                  // returns the time of the next scheduled alarm
+  time_t getNextTrigger();                  // returns the time of the next enabled alarm, or 0 if none. O(1)
   bool isAllocated(AlarmID_t ID);           // returns true if this id is allocated  
   bool isAlarm(AlarmID_t ID);               // returns true if id is for a time based alarm, false if its a timer or not allocated
 };
@@ -55,15 +55,15 @@ boolean BIOSDigitalSoilMeter::justRight() {
   return ( this->currMoist + 1 == this->maxMoist );
 }
 
-// see http://rayshobby.net/reverse-engineer-a-cheap-wireless-soil-moisture-sensor/
+// the frame's fields are RadioRx's; see RadioRx.h
 unsigned long BIOSDigitalSoilMeter::decodeAddress(unsigned long data) {
-  return ( getBits(data, 32, 8) );
+  return ( biosAddress(data) );
 }
 float BIOSDigitalSoilMeter::decodeTemp(unsigned long data) {
-  return ( float(getBits(data, 20, 12)) / 10.0 );
+  return ( biosTemp(data) / 10.0 );
 }
 byte BIOSDigitalSoilMeter::decodeMoist(unsigned long data) {
-  return ( getBits(data, 8, 4) );
+  return ( biosMoist(data) );
 }
 
 void EtekcityOutlet::begin(char * name, unsigned long onCode, unsigned long offCode, int bitLength, int pulseLength, int protocol) {
@@ -156,12 +156,6 @@ void EtekcityOutlet::print() {
   Serial << endl;
 }
 
-// helper function
-unsigned long getBits(unsigned long data, int startBit, int nBits) {
-  const int dataLen = 32;
-  return ( ( data << (dataLen - startBit) ) >> (dataLen - nBits) );
-}
-
 float convertCtoF(float c) {
   return c * 9.0 / 5.0 + 32.0;
 }
@@ -5,6 +5,7 @@
 
 #include <Streaming.h>
 #include <RCSwitch.h>
+#include <RadioRx.h>
 
 class BIOSDigitalSoilMeter {
   public:
@@ -32,7 +33,7 @@ class BIOSDigitalSoilMeter {
     // store sensor name
     char name[20];
   
-    // store the sensor address code
+    // store the sensor address code: 9 bits, see biosAddress()
     unsigned long sensorAddress;
 
     // stores last sensor update time
@@ -95,7 +96,6 @@ private:
  };
 
 // helper functions
-unsigned long getBits(unsigned long data, int startBit, int nBits) ;
 float convertCtoF(float c);
 float convertFtoC(float f);
 float computeHeatIndex(float tempFahrenheit, float percentHumidity);
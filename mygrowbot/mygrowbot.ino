@@ -2,16 +2,21 @@
 #include <Metro.h>
 #define RCSwitchDisableReceiving
 #include <RCSwitch.h>
+#include <RadioRx.h>
 #include <DS3231.h>
 #include <Wire.h>
 
 // see AT24C32_TEST example for I2C memory (32k) for logging
 
-// configure radio
+// configure radio.  RCSwitch transmits; RadioRx, shared with the other sketches, receives the sensors.
 RCSwitch radio = RCSwitch();
+const RadioProtocol protocols[] = { RADIO_TB304BC };
+RadioChannel channels[1];
+RadioRx rx;
 
 // configure RTC
 DS3231 rtc;
+#define RTCINTPIN 3 // DS3231 INT/SQW; D3 is int.1
 
 // sensor and pump abstraction
 #include "Bed.h"
@@ -40,9 +45,6 @@ int maxWaterTime = 4; // hr
 #define DEBUG_RADIO true
 #define DATAPIN 2 // D2 is int.0
 
-// track if we've got sensor data
-bool sensorReceived = false;
-
 void setup() {
   Serial.begin(115200);
 
@@ -68,13 +70,19 @@ void setup() {
   // send 20,59,45,4,27,11 to simulate a watering run.
   rtc.turnOnAlarm(1);
   Serial << F("Watering alarm enabled? ") << rtc.checkAlarmEnabled(1) << endl;
+  // alarm arrives on the INT pin instead of being polled over I2C
+  if ( !rtc.attachAlarmInterrupt(RTCINTPIN) ) {
+    Serial << F("RTC: error. INT pin must be 2 or 3.") << endl;
+  }
+  // a flag left over from before the reset holds INT low; clear it so the next alarm gives an edge
+  rtc.checkIfAlarm(1);
 
   // Radio module
   // receive
   //  radio.enableReceive(0);      // Receiver DATA line on interrupt 0 => that is pin D2
   // can't get RC Switch to work with the Thermor BIOS sensors.  So, we can't listen to the manual switches.  Pity.
-  pinMode(DATAPIN, INPUT);
-  attachInterrupt(0, handler, CHANGE); // D2 is int.0
+  rx.begin(protocols, channels, 1);
+  rx.attach(DATAPIN);
 
   // transmit
   radio.enableTransmit(10);    // Transmitter DATA line on pin D10
@@ -88,13 +96,12 @@ void setup() {
   //  pump[3].begin("Pump 4", 1383683, 1383692);
   //  pump[4].begin("Pump 5", 1389827, 1389836);
 
-  // sensors
+  // sensors, by the 9-bit address (see biosAddress() in RadioRx.h).  these were 12-bit codes
+  // 320 (or 324), 864 (or 868) and 1949; the low 3 bits are flags, and wander.
   Serial << F("Sensors:") << endl;
-//  sensor[0].begin("South Bed", 324, 6, 10);
-//  sensor[1].begin("West Bed", 868, 6, 10);
-  sensor[0].begin("South Bed", 320, 6, 10);
-  sensor[1].begin("West Bed", 864, 6, 10);
-  sensor[2].begin("Flower Bed", 1949, 4, 8);   // try to keep this bed drier
+  sensor[0].begin("South Bed", 40, 6, 10);
+  sensor[1].begin("West Bed", 108, 6, 10);
+  sensor[2].begin("Flower Bed", 243, 4, 8);   // try to keep this bed drier
 
   // pump and sensor relationships
   Serial << F("Pump waters Sensors:") << endl;
@@ -131,17 +138,10 @@ void loop() {
     ledTooDry();
   }
 
-  // check alarm for Watering time
-  static Metro checkAlarm(1000UL); // every second.
-  if ( checkAlarm.check() ) {
-    checkAlarm.reset();
-    // the RTC needs to be polled on an interval to actually set alarm flag.
-    byte toss = rtc.getSecond();
-    if ( rtc.checkIfAlarm(1) ) {
-      wateringTime();
-    }
+  // check alarm for Watering time.  only touches the I2C bus once INT has fired.
+  if ( rtc.alarmLatched() && rtc.checkIfAlarm(1) ) {
+    wateringTime();
   }
-
 }
 
 void wateringTime() {
@@ -240,151 +240,21 @@ void wateringTime() {
 }
 
 
-// ring buffer size has to be large enough to fit
-// data between two successive sync signals
-//#define RING_BUFFER_SIZE  256
-#define RING_BUFFER_SIZE 78
-
-#define SYNC_LENGTH  9000
-#define SEP_LENGTH   500
-#define BIT1_LENGTH  4000
-#define BIT0_LENGTH  2000
-
-unsigned long timings[RING_BUFFER_SIZE];
-unsigned int syncIndex1 = 0;  // index of the first sync signal
-unsigned int syncIndex2 = 0;  // index of the second sync signal
-
-// detect if a sync signal is present
-bool isSync(unsigned int idx) {
-  unsigned long t0 = timings[(idx + RING_BUFFER_SIZE - 1) % RING_BUFFER_SIZE];
-  unsigned long t1 = timings[idx];
-
-  // on the temperature sensor, the sync signal
-  // is roughtly 9.0ms. Accounting for error
-  // it should be within 8.0ms and 10.0ms
-  if (t0 > (SEP_LENGTH - 100) && t0 < (SEP_LENGTH + 100) &&
-      t1 > (SYNC_LENGTH - 1000) && t1 < (SYNC_LENGTH + 1000) &&
-      digitalRead(DATAPIN) == HIGH) {
-    return true;
-  }
-  return false;
-}
-
-/* Interrupt 1 handler */
-void handler() {
-  static unsigned long duration = 0;
-  static unsigned long lastTime = 0;
-  static unsigned int ringIndex = 0;
-  static unsigned int syncCount = 0;
-
-  // ignore if we haven't processed the previous received signal
-  if (sensorReceived == true) {
-    return;
-  }
-  // calculating timing since last change
-  long time = micros();
-  duration = time - lastTime;
-  lastTime = time;
-
-  // store data in ring buffer
-  ringIndex = (ringIndex + 1) % RING_BUFFER_SIZE;
-  timings[ringIndex] = duration;
-
-  // detect sync signal
-  if (isSync(ringIndex)) {
-    syncCount ++;
-    // first time sync is seen, record buffer index
-    if (syncCount == 1) {
-      syncIndex1 = (ringIndex + 1) % RING_BUFFER_SIZE;
-    }
-    else if (syncCount == 2) {
-      // second time sync is seen, start bit conversion
-      syncCount = 0;
-      syncIndex2 = (ringIndex + 1) % RING_BUFFER_SIZE;
-      unsigned int changeCount = (syncIndex2 < syncIndex1) ? (syncIndex2 + RING_BUFFER_SIZE - syncIndex1) : (syncIndex2 - syncIndex1);
-      // changeCount must be 66 -- 32 bits x 2 + 2 for sync
-//      if (changeCount != 76) {
-      if (changeCount != 38*2) {
-        sensorReceived = false;
-        syncIndex1 = 0;
-        syncIndex2 = 0;
-      }
-      else {
-        sensorReceived = true;
-      }
-    }
-  }
-}
-
 void getSensorData() {
-  unsigned long recv = 0;
-
-  if ( sensorReceived ) {
-    // disable interrupt to avoid new data corrupting the buffer
-    detachInterrupt(0);
-
-    // loop over buffer data
-    byte bitCount = 0;
-    unsigned long address = 0;
-    unsigned long temp = 0;
-    unsigned long hum = 0;
-    for (unsigned int i = syncIndex1; i != syncIndex2; i = (i + 2) % RING_BUFFER_SIZE) {
-      unsigned long t0 = timings[i], t1 = timings[(i + 1) % RING_BUFFER_SIZE];
-      if (t0 > (SEP_LENGTH - 100) && t0 < (SEP_LENGTH + 100)) {
-        if (t1 > (BIT1_LENGTH - 1000) && t1 < (BIT1_LENGTH + 1000)) {
-  //        Serial << F("1");
-          if ( bitCount < 12) {
-            address = address << 1;
-            address += 1;
-          } else if ( bitCount < 12 + 12 ) {
-            temp = temp << 1;
-            temp += 1;
-          } else if ( bitCount < 12 + 12 + 4 ) {
-            hum = hum << 1;
-            hum += 1;
-          }
-          bitCount++;
-        } else {
- //         Serial << F("0");
-          if ( bitCount < 12) {
-            address = address << 1;
-          } else if ( bitCount < 12 + 12 ) {
-            temp = temp << 1;
-          } else if ( bitCount < 12 + 12 + 4 ) {
-            hum = hum << 1;
-          }
-          bitCount++;
-        }
-      } else {
- //       Serial << F("?");
-      }
-    }
-//    Serial << endl;
-
-    if ( bitCount >= 12 + 12 + 4 && DEBUG_RADIO) {
-      Serial << dec2binWzerofill(address, 12) << dec2binWzerofill(temp, 12) << dec2binWzerofill(hum, 4) << endl;
-      Serial << F("bitcount: ") << bitCount << endl;
-      Serial << F("Address: ") << address << F(" ") << dec2binWzerofill(address, 32) << endl;
-      Serial << F("Temp: ") << float(temp / 10.0) << F(" ") << dec2binWzerofill(temp, 32) << endl;
-      Serial << F("Humidity: ") << hum << F(" ") << dec2binWzerofill(hum, 32) << endl;
-    }
-
-    for (int i = 0; i < nSensors; i++) {
-      if( sensor[i].sensorAddress == address ) {
-        sensor[i].currMoist = hum;
-        sensor[i].currTemp = float(temp/10.0);
-        sensor[i].lastSensorRead = millis();
-        sensor[i].print();
-      
-        delay(1000); // wait to drop duplicates/
-      }
-    }
+  // repeats are dropped by RadioRx
+  if ( !rx.available() ) return;
+  unsigned long recv = rx.message();
+
+  if ( DEBUG_RADIO ) {
+    Serial << dec2binWzerofill(recv, 32) << endl;
+    Serial << F("Address: ") << biosAddress(recv) << F(" flags: ") << biosFlags(recv) << endl;
+    Serial << F("Temp: ") << biosTemp(recv) / 10.0 << endl;
+    Serial << F("Humidity: ") << biosMoist(recv) << endl;
+  }
 
-    // reattach
-    attachInterrupt(0, handler, CHANGE);
-    sensorReceived = false; // clear flag
+  for (int i = 0; i < nSensors; i++) sensor[i].readSensor(recv);
 
-  }
+  rx.clear();
 }
 
 
@@ -434,12 +304,12 @@ void pumpsAllOff() {
 }
 
 void printTime() {
-  static bool h12 = false;
-  static bool PM = false;
-  static bool Century = false;
+  // a burst read when the second is due to turn over; every reading in between works from millis()
+  DS3231Snapshot t;
+  rtc.getCachedTime(t);
 
-  Serial << rtc.getHour(h12, PM) << F(":") << rtc.getMinute() << F(":") << rtc.getSecond() << F(" ");
-  Serial << rtc.getMonth(Century) << F("/") << rtc.getDate() << F("/") << rtc.getYear();
+  Serial << t.hour << F(":") << t.minute << F(":") << t.second << F(" ");
+  Serial << t.month << F("/") << t.date << F("/") << t.year;
 }
 
 // some morse code to indicate what we're doing
@@ -0,0 +1,495 @@
+/*
+
+binlogdump: decode BinLog serial captures (see libraries/BinLog/BinLog.h) on a host.
+
+Build:   g++ -O2 -std=c++11 -o binlogdump binlogdump.cpp
+Capture: stty -F /dev/ttyUSB0 115200 raw && cat /dev/ttyUSB0 >> garden.log
+
+Usage:   binlogdump [-t] [-c dir] [-b dir] [-T dir] [file]
+
+  (default) one text line per record, stamped with RTC time once a LOG_CLOCK
+            record has been seen and with controller millis() before that
+  -t        also pass through the plain text the sketch prints between records
+  -c dir    one CSV per event, dir/NAME.csv: ms, time, then one column per argument
+  -b dir    columnar: per event, dir/NAME.K.TYPE holds argument K as a packed
+            little-endian array (u8 i16 u16 i32 u32 f32; strings as lines in .txt),
+            with dir/NAME.ms.u64 the timestamps.  numpy.fromfile() reads them.
+  -T dir    timelines from the GardenBot_v1 events:
+              dir/moisture_BED.csv  per bed moisture and temperature (LOG_SENSOR)
+              dir/duty_PUMP.csv     pump on/off intervals (LOG_OUTLET)
+              dir/frames.csv        raw radio frames (LOG_FRAME); TB304BC frames
+                                    are split into address, moisture and temperature
+                                    with the same bit fields as BIOSDigitalSoilMeter
+            and a pump duty summary on stdout.
+
+Files are memory-mapped and read front to back once; nothing is held per record,
+so months of logs go through in the time it takes to read them.  A format table
+(sent by Log.begin() at every controller reset) starts a new session: millis()
+starts over and the clock has to be seen again.  millis() wrapping after 49 days
+is carried into the 64-bit timestamps.
+
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <map>
+#include <string>
+#include <vector>
+
+// must match BinLog.h
+#define BINLOG_HEADER 7
+#define BINLOG_SYNC 0xF5
+#define BINLOG_FORMAT 0xFE
+#define BINLOG_DROPPED 0xFF
+
+enum ArgType { A_U8, A_CHAR, A_I16, A_U16, A_X16, A_I32, A_U32, A_X32, A_F32, A_STR };
+static const char *typeSuffix[] = { "u8", "u8", "i16", "u16", "u16", "i32", "u32", "u32", "f32", "txt" };
+
+struct Arg {
+  ArgType type;
+  std::string before; // literal text ahead of this conversion
+};
+
+struct Event {
+  std::string name;
+  std::vector<Arg> args;
+  std::string after;  // literal text after the last conversion
+  bool known;
+  Event() : known(false) {}
+};
+
+struct Value {
+  ArgType type;
+  int64_t i;
+  double f;
+  std::string s;
+};
+
+// ---------------------------------------------------------------- formats
+
+static Event parseFormat(const uint8_t *p, size_t n) {
+  Event e;
+  e.known = true;
+  std::string text((const char *)p, n);
+  size_t tab = text.find('\t');
+  std::string fmt = text;
+  if ( tab != std::string::npos ) {
+    e.name = text.substr(0, tab);
+    fmt = text.substr(tab + 1);
+  }
+
+  std::string lit;
+  for ( size_t i = 0; i < fmt.size(); i++ ) {
+    if ( fmt[i] != '%' || i + 1 >= fmt.size() ) { lit += fmt[i]; continue; }
+    char c = fmt[++i];
+    bool isLong = false;
+    if ( c == 'l' && i + 1 < fmt.size() ) { isLong = true; c = fmt[++i]; }
+    Arg a;
+    switch ( c ) {
+      case '%': lit += '%'; continue;
+      case 'b': a.type = A_U8; break;
+      case 'c': a.type = A_CHAR; break;
+      case 'd': a.type = isLong ? A_I32 : A_I16; break;
+      case 'u': a.type = isLong ? A_U32 : A_U16; break;
+      case 'x': a.type = isLong ? A_X32 : A_X16; break;
+      case 'f': a.type = A_F32; break;
+      case 's': a.type = A_STR; break;
+      default: lit += '%'; lit += c; continue;
+    }
+    a.before = lit;
+    lit.clear();
+    e.args.push_back(a);
+  }
+  e.after = lit;
+  return e;
+}
+
+// pull the arguments out of a record.  false if the record is shorter than its format.
+static bool readArgs(const Event &e, const uint8_t *p, size_t n, std::vector<Value> &vals) {
+  static const size_t sizes[] = { 1, 1, 2, 2, 2, 4, 4, 4, 4, 0 };
+  vals.resize(e.args.size());
+  size_t at = 0;
+  for ( size_t k = 0; k < e.args.size(); k++ ) {
+    Value &v = vals[k];
+    v.type = e.args[k].type;
+    size_t sz = sizes[v.type];
+    if ( v.type == A_STR ) {
+      if ( at >= n || at + 1 + p[at] > n ) return false;
+      v.s.assign((const char *)p + at + 1, p[at]);
+      at += 1 + p[at];
+      continue;
+    }
+    if ( at + sz > n ) return false;
+    uint32_t raw = 0;
+    for ( size_t b = 0; b < sz; b++ ) raw |= (uint32_t)p[at + b] << (8 * b);
+    at += sz;
+    switch ( v.type ) {
+      case A_I16: v.i = (int16_t)raw; break;
+      case A_I32: v.i = (int32_t)raw; break;
+      case A_F32: { float f; memcpy(&f, &raw, 4); v.f = f; v.i = 0; break; }
+      default: v.i = raw; break;
+    }
+  }
+  return true;
+}
+
+static std::string valueText(const Value &v) {
+  char buf[32];
+  switch ( v.type ) {
+    case A_STR: return v.s;
+    case A_CHAR: buf[0] = (char)v.i; buf[1] = 0; break;
+    case A_X16: case A_X32: snprintf(buf, sizeof(buf), "%llx", (unsigned long long)v.i); break;
+    case A_F32: snprintf(buf, sizeof(buf), "%.2f", v.f); break;
+    default: snprintf(buf, sizeof(buf), "%lld", (long long)v.i); break;
+  }
+  return buf;
+}
+
+static std::string expand(const Event &e, const std::vector<Value> &vals) {
+  std::string out;
+  for ( size_t k = 0; k < e.args.size(); k++ ) out += e.args[k].before + valueText(vals[k]);
+  return out + e.after;
+}
+
+// ---------------------------------------------------------------- time
+
+// days since 1970-01-01 for a civil date
+static int64_t daysFromCivil(int y, unsigned m, unsigned d) {
+  y -= m <= 2;
+  const int64_t era = (y >= 0 ? y : y - 399) / 400;
+  const unsigned yoe = (unsigned)(y - era * 400);
+  const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + (int64_t)doe - 719468;
+}
+
+struct Session {
+  uint64_t wrap;       // 2^32 per millis() rollover seen
+  uint32_t lastMs;
+  bool haveClock;
+  int64_t clockWallMs; // wall time at clockMs, ms since the epoch
+  uint64_t clockMs;
+  void reset() { wrap = 0; lastMs = 0; haveClock = false; clockWallMs = 0; clockMs = 0; }
+};
+
+static std::string timeText(const Session &s, uint64_t ms) {
+  char buf[40];
+  if ( !s.haveClock ) {
+    snprintf(buf, sizeof(buf), "+%llu.%03u", (unsigned long long)(ms / 1000), (unsigned)(ms % 1000));
+    return buf;
+  }
+  int64_t wall = s.clockWallMs + (int64_t)(ms - s.clockMs);
+  time_t sec = (time_t)(wall / 1000);
+  struct tm tm;
+  gmtime_r(&sec, &tm);
+  size_t n = strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+  snprintf(buf + n, sizeof(buf) - n, ".%03u", (unsigned)(wall % 1000));
+  return buf;
+}
+
+// ---------------------------------------------------------------- outputs
+
+static std::string safeName(const std::string &s) {
+  std::string out;
+  for ( size_t i = 0; i < s.size(); i++ ) {
+    char c = s[i];
+    out += ( (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' ) ? c : '_';
+  }
+  return out;
+}
+
+static FILE *openOut(const std::string &dir, const std::string &name, const char *header) {
+  std::string path = dir + "/" + name;
+  FILE *f = fopen(path.c_str(), "w");
+  if ( !f ) { perror(path.c_str()); exit(1); }
+  if ( header ) fputs(header, f);
+  return f;
+}
+
+// open files by name, so each is opened once per run
+struct Files {
+  std::map<std::string, FILE *> open;
+  FILE *get(const std::string &dir, const std::string &name, const char *header) {
+    std::map<std::string, FILE *>::iterator it = open.find(name);
+    if ( it != open.end() ) return it->second;
+    FILE *f = openOut(dir, name, header);
+    open[name] = f;
+    return f;
+  }
+  ~Files() {
+    for ( std::map<std::string, FILE *>::iterator it = open.begin(); it != open.end(); ++it ) fclose(it->second);
+  }
+};
+
+struct PumpDuty {
+  bool on, seen;         // seen: this session
+  uint64_t since;
+  std::string sinceText;
+  uint64_t total, span;  // ms on, and ms covered by the log, over all sessions
+  uint64_t first, last;  // this session
+  unsigned cycles;
+  PumpDuty() : on(false), seen(false), since(0), total(0), span(0), first(0), last(0), cycles(0) {}
+};
+
+struct Options {
+  bool text;
+  const char *csvDir, *colDir, *timelineDir;
+  Options() : text(false), csvDir(0), colDir(0), timelineDir(0) {}
+};
+
+class Decoder {
+  public:
+    Decoder(const Options &o) : opt(o), nRecords(0), nDropped(0), nBad(0), sessionId(0) { session.reset(); }
+
+    void run(const uint8_t *p, size_t n);
+    void finish();
+
+  private:
+    const Options &opt;
+    Event events[256];
+    Session session;
+    Files csv, cols, timeline;
+    std::map<std::string, PumpDuty> duty;
+    std::vector<Value> vals;
+    std::string textLine;
+    unsigned long long nRecords, nDropped, nBad;
+    unsigned sessionId;
+
+    void record(uint8_t id, uint32_t ms32, const uint8_t *args, size_t len);
+    void text(uint8_t c);
+    void writeCsv(const Event &e, uint64_t ms, const std::string &when);
+    void writeColumns(const Event &e, uint64_t ms);
+    void writeTimeline(const Event &e, uint64_t ms, const std::string &when);
+};
+
+void Decoder::run(const uint8_t *p, size_t n) {
+  size_t i = 0;
+  while ( i < n ) {
+    if ( p[i] != BINLOG_SYNC ) { text(p[i++]); continue; }
+    // a sync byte needs a whole header and a known id behind it to be a record;
+    // otherwise it is line noise and goes out as text
+    if ( i + BINLOG_HEADER > n ) break;
+    uint8_t id = p[i + 1];
+    size_t len = p[i + 2];
+    bool plausible = ( id == BINLOG_FORMAT || id == BINLOG_DROPPED || events[id].known );
+    if ( !plausible ) { nBad++; text(p[i++]); continue; }
+    if ( i + BINLOG_HEADER + len > n ) break; // cut off at the end of the capture
+    uint32_t ms = p[i + 3] | (p[i + 4] << 8) | (p[i + 5] << 16) | ((uint32_t)p[i + 6] << 24);
+    record(id, ms, p + i + BINLOG_HEADER, len);
+    i += BINLOG_HEADER + len;
+  }
+}
+
+void Decoder::text(uint8_t c) {
+  if ( !opt.text ) return;
+  if ( c == '\r' ) return;
+  if ( c == '\n' ) {
+    printf("%s\n", textLine.c_str());
+    textLine.clear();
+  } else {
+    textLine += (char)c;
+  }
+}
+
+void Decoder::record(uint8_t id, uint32_t ms32, const uint8_t *args, size_t len) {
+  if ( id == BINLOG_FORMAT ) {
+    if ( len < 1 ) return;
+    // event 0 comes first in every table: the controller has restarted
+    if ( args[0] == 0 ) {
+      // a run cut short by the reset isn't counted: when it ended is unknown
+      for ( std::map<std::string, PumpDuty>::iterator it = duty.begin(); it != duty.end(); ++it ) {
+        PumpDuty &d = it->second;
+        if ( d.seen ) d.span += d.last - d.first;
+        d.on = d.seen = false;
+      }
+      session.reset();
+      for ( int k = 0; k < 256; k++ ) events[k] = Event();
+      sessionId++;
+    }
+    Event e = parseFormat(args + 1, len - 1);
+    if ( e.name.empty() ) {
+      char buf[8];
+      snprintf(buf, sizeof(buf), "E%u", args[0]);
+      e.name = buf;
+    }
+    events[args[0]] = e;
+    return;
+  }
+
+  // 64-bit controller time.  a step back of more than half the range is a rollover
+  if ( ms32 < session.lastMs && session.lastMs - ms32 > 0x80000000UL ) session.wrap += 0x100000000ULL;
+  session.lastMs = ms32;
+  uint64_t ms = session.wrap + ms32;
+  nRecords++;
+
+  if ( id == BINLOG_DROPPED ) {
+    unsigned n = len >= 2 ? args[0] | (args[1] << 8) : 0;
+    nDropped += n;
+    if ( !opt.csvDir && !opt.colDir && !opt.timelineDir ) {
+      printf("%s  (%u records dropped)\n", timeText(session, ms).c_str(), n);
+    }
+    return;
+  }
+
+  const Event &e = events[id];
+  if ( !readArgs(e, args, len, vals) ) { nBad++; return; }
+
+  if ( e.name == "LOG_CLOCK" && vals.size() >= 6 ) {
+    int64_t days = daysFromCivil(2000 + (int)vals[5].i, (unsigned)vals[3].i, (unsigned)vals[4].i);
+    session.clockWallMs = ((days * 24 + vals[0].i) * 60 + vals[1].i) * 60000 + vals[2].i * 1000;
+    session.clockMs = ms;
+    session.haveClock = true;
+  }
+
+  std::string when = timeText(session, ms);
+  if ( !opt.csvDir && !opt.colDir && !opt.timelineDir ) printf("%s  %s\n", when.c_str(), expand(e, vals).c_str());
+  if ( opt.csvDir ) writeCsv(e, ms, when);
+  if ( opt.colDir ) writeColumns(e, ms);
+  if ( opt.timelineDir ) writeTimeline(e, ms, when);
+}
+
+void Decoder::writeCsv(const Event &e, uint64_t ms, const std::string &when) {
+  std::string header = "session,ms,time";
+  for ( size_t k = 0; k < e.args.size(); k++ ) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), ",arg%u", (unsigned)k + 1);
+    header += buf;
+  }
+  header += "\n";
+  FILE *f = csv.get(opt.csvDir, safeName(e.name) + ".csv", header.c_str());
+  fprintf(f, "%u,%llu,%s", sessionId, (unsigned long long)ms, when.c_str());
+  for ( size_t k = 0; k < vals.size(); k++ ) {
+    if ( vals[k].type == A_STR ) fprintf(f, ",\"%s\"", vals[k].s.c_str());
+    else fprintf(f, ",%s", valueText(vals[k]).c_str());
+  }
+  fputc('\n', f);
+}
+
+void Decoder::writeColumns(const Event &e, uint64_t ms) {
+  std::string base = safeName(e.name);
+  fwrite(&ms, sizeof(ms), 1, cols.get(opt.colDir, base + ".ms.u64", 0));
+  for ( size_t k = 0; k < vals.size(); k++ ) {
+    char name[64];
+    snprintf(name, sizeof(name), "%s.%u.%s", base.c_str(), (unsigned)k + 1, typeSuffix[vals[k].type]);
+    FILE *f = cols.get(opt.colDir, name, 0);
+    const Value &v = vals[k];
+    switch ( v.type ) {
+      case A_STR: fprintf(f, "%s\n", v.s.c_str()); break;
+      case A_U8: case A_CHAR: { uint8_t x = (uint8_t)v.i; fwrite(&x, 1, 1, f); break; }
+      case A_I16: { int16_t x = (int16_t)v.i; fwrite(&x, 2, 1, f); break; }
+      case A_U16: case A_X16: { uint16_t x = (uint16_t)v.i; fwrite(&x, 2, 1, f); break; }
+      case A_I32: { int32_t x = (int32_t)v.i; fwrite(&x, 4, 1, f); break; }
+      case A_U32: case A_X32: { uint32_t x = (uint32_t)v.i; fwrite(&x, 4, 1, f); break; }
+      case A_F32: { float x = (float)v.f; fwrite(&x, 4, 1, f); break; }
+    }
+  }
+}
+
+// TB304BC field layout, as BIOSDigitalSoilMeter::decodeAddress/decodeMoist/decodeTemp
+static uint32_t getBits(uint32_t data, int startBit, int nBits) {
+  return ( (uint32_t)(data << (32 - startBit)) ) >> (32 - nBits);
+}
+
+void Decoder::writeTimeline(const Event &e, uint64_t ms, const std::string &when) {
+  if ( e.name == "LOG_SENSOR" && vals.size() >= 5 ) {
+    FILE *f = timeline.get(opt.timelineDir, "moisture_" + safeName(vals[0].s) + ".csv",
+                           "ms,time,moisture,min,max,temp_f\n");
+    fprintf(f, "%llu,%s,%lld,%lld,%lld,%.1f\n", (unsigned long long)ms, when.c_str(),
+            (long long)vals[1].i, (long long)vals[2].i, (long long)vals[3].i, vals[4].f);
+  } else if ( e.name == "LOG_OUTLET" && vals.size() >= 2 ) {
+    PumpDuty &d = duty[vals[0].s];
+    bool on = vals[1].i != 0;
+    if ( !d.seen ) d.first = ms;
+    d.seen = true;
+    d.last = ms;
+    if ( on && !d.on ) {
+      d.since = ms;
+      d.sinceText = when;
+      d.cycles++;
+    } else if ( !on && d.on ) {
+      d.total += ms - d.since;
+      FILE *f = timeline.get(opt.timelineDir, "duty_" + safeName(vals[0].s) + ".csv", "on,off,seconds\n");
+      fprintf(f, "%s,%s,%.1f\n", d.sinceText.c_str(), when.c_str(), (ms - d.since) / 1000.0);
+    }
+    d.on = on;
+  } else if ( e.name == "LOG_FRAME" && vals.size() >= 3 ) {
+    FILE *f = timeline.get(opt.timelineDir, "frames.csv", "ms,time,protocol,bits,message,address,moisture,temp_c\n");
+    uint32_t m = (uint32_t)vals[2].i;
+    fprintf(f, "%llu,%s,%lld,%lld,%u", (unsigned long long)ms, when.c_str(), (long long)vals[0].i, (long long)vals[1].i, m);
+    if ( vals[0].i == 0 ) {
+      int temp = (int)getBits(m, 20, 12);
+      if ( temp & 0x800 ) temp -= 0x1000; // 12-bit two's complement
+      fprintf(f, ",%u,%u,%.1f\n", getBits(m, 32, 9), getBits(m, 8, 4), temp / 10.0);
+    } else {
+      fputs(",,,\n", f);
+    }
+  }
+}
+
+void Decoder::finish() {
+  if ( opt.text && !textLine.empty() ) printf("%s\n", textLine.c_str());
+  if ( opt.timelineDir ) {
+    printf("pump,cycles,on_s,span_s,duty_pct\n");
+    for ( std::map<std::string, PumpDuty>::iterator it = duty.begin(); it != duty.end(); ++it ) {
+      const PumpDuty &d = it->second;
+      double span = (d.span + (d.seen ? d.last - d.first : 0)) / 1000.0;
+      double on = d.total / 1000.0;
+      printf("\"%s\",%u,%.0f,%.0f,%.2f\n", it->first.c_str(), d.cycles, on, span, span > 0 ? 100.0 * on / span : 0.0);
+    }
+  }
+  fprintf(stderr, "%llu records, %llu dropped on the controller, %llu unreadable\n", nRecords, nDropped, nBad);
+}
+
+// ---------------------------------------------------------------- main
+
+static void usage() {
+  fprintf(stderr, "usage: binlogdump [-t] [-c csvdir] [-b columndir] [-T timelinedir] [file]\n");
+  exit(2);
+}
+
+int main(int argc, char **argv) {
+  Options opt;
+  int c;
+  while ( (c = getopt(argc, argv, "tc:b:T:")) != -1 ) {
+    switch ( c ) {
+      case 't': opt.text = true; break;
+      case 'c': opt.csvDir = optarg; break;
+      case 'b': opt.colDir = optarg; break;
+      case 'T': opt.timelineDir = optarg; break;
+      default: usage();
+    }
+  }
+  if ( argc - optind > 1 ) usage();
+
+  Decoder d(opt);
+  if ( optind < argc ) {
+    int fd = open(argv[optind], O_RDONLY);
+    if ( fd < 0 ) { perror(argv[optind]); return 1; }
+    struct stat st;
+    if ( fstat(fd, &st) < 0 ) { perror(argv[optind]); return 1; }
+    if ( st.st_size > 0 ) {
+      void *m = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if ( m == MAP_FAILED ) { perror("mmap"); return 1; }
+      madvise(m, st.st_size, MADV_SEQUENTIAL);
+      d.run((const uint8_t *)m, st.st_size);
+      munmap(m, st.st_size);
+    }
+    close(fd);
+  } else {
+    // a pipe can't be mapped; read it whole
+    std::vector<uint8_t> buf;
+    uint8_t chunk[65536];
+    size_t n;
+    while ( (n = fread(chunk, 1, sizeof(chunk), stdin)) > 0 ) buf.insert(buf.end(), chunk, chunk + n);
+    if ( !buf.empty() ) d.run(&buf[0], buf.size());
+  }
+  d.finish();
+  return 0;
+}
@@ -0,0 +1,53 @@
+/*
+
+Just enough of the Arduino core to build the libraries' arithmetic on a host,
+for the checks under tools/.  Nothing here touches hardware: millis() is a
+clock the program advances itself, through hostMillis, and delay() moves it.
+
+Build a check with -I../host and link ../host/host.cpp.  Remember that
+unsigned long is 64 bits here and 32 on the AVR, so where a library leans on
+32-bit wrap-around, compare it against a reference in the same types rather
+than against numbers worked out by hand.
+
+*/
+
+#ifndef host_Arduino_h
+#define host_Arduino_h
+
+// nothing that brings the host's time_t (<stdlib.h>, <math.h>, <time.h>): Time.h has its own
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define FALLING 2
+
+// no pins and no interrupts
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t) { return( LOW ); }
+inline void attachInterrupt(uint8_t, void (*)(), int) {}
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+// functions here, where the core has macros, so the C++ headers still build after this one
+template <class T> inline T abs(T x) { return( x < 0 ? -x : x ); }
+template <class T, class U, class V> inline T constrain(T x, U lo, V hi) { return( x < lo ? lo : x > hi ? hi : x ); }
+// constexpr, so they still size arrays
+template <class T, class U> constexpr typename std::common_type<T, U>::type min(T a, U b) { return( a < b ? a : b ); }
+template <class T, class U> constexpr typename std::common_type<T, U>::type max(T a, U b) { return( a > b ? a : b ); }
+
+// ms; the program sets and advances it
+extern unsigned long hostMillis;
+
+inline unsigned long millis() { return( hostMillis ); }
+inline unsigned long micros() { return( hostMillis * 1000 ); }
+inline void delay(unsigned long ms) { hostMillis += ms; }
+
+#endif
@@ -0,0 +1,2 @@
+// pre-1.0 sketches and libraries include this instead
+#include "Arduino.h"
@@ -0,0 +1,21 @@
+#ifndef host_Wire_h
+#define host_Wire_h
+
+#include "Arduino.h"
+
+// no bus: writes go nowhere and reads are 0
+class TwoWire {
+  public:
+    void begin() {}
+    void beginTransmission(uint8_t) {}
+    byte endTransmission() { return( 0 ); }
+    byte requestFrom(uint8_t, uint8_t) { return( 0 ); }
+    size_t write(uint8_t) { return( 1 ); }
+    void send(uint8_t) {}
+    int read() { return( 0 ); }
+    byte receive() { return( 0 ); }
+};
+
+extern TwoWire Wire;
+
+#endif
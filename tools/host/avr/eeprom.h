@@ -0,0 +1,22 @@
+#ifndef host_eeprom_h
+#define host_eeprom_h
+
+#include <stdint.h>
+#include <string.h>
+
+// the EEPROM is hostEeprom, in host.cpp.  twice the ATmega328P's 1 KB, since a struct
+// holding an unsigned long is bigger here.
+#define E2END 2047
+
+extern uint8_t hostEeprom[E2END + 1];
+
+#define EEPROM_AT(a) (hostEeprom + (uintptr_t)(a))
+
+inline uint8_t eeprom_read_byte(const uint8_t *a) { return( *EEPROM_AT(a) ); }
+inline uint16_t eeprom_read_word(const uint16_t *a) { uint16_t w; memcpy(&w, EEPROM_AT(a), 2); return( w ); }
+inline void eeprom_read_block(void *d, const void *a, size_t n) { memcpy(d, EEPROM_AT(a), n); }
+inline void eeprom_update_byte(uint8_t *a, uint8_t b) { *EEPROM_AT(a) = b; }
+inline void eeprom_update_word(uint16_t *a, uint16_t w) { memcpy(EEPROM_AT(a), &w, 2); }
+inline void eeprom_update_block(const void *s, void *a, size_t n) { memcpy(EEPROM_AT(a), s, n); }
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef host_pgmspace_h
+#define host_pgmspace_h
+
+#include <stdint.h>
+#include <string.h>
+
+// flash is just memory here
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+#define pgm_read_dword(p) (*(const uint32_t *)(p))
+#define memcpy_P memcpy
+#define strcpy_P strcpy
+
+#endif
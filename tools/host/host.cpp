@@ -0,0 +1,7 @@
+#include "Arduino.h"
+#include "Wire.h"
+#include "avr/eeprom.h"
+
+unsigned long hostMillis = 0;
+TwoWire Wire;
+uint8_t hostEeprom[E2END + 1];
@@ -0,0 +1,13 @@
+#ifndef host_crc16_h
+#define host_crc16_h
+
+#include <stdint.h>
+
+// avr-libc's, in C: polynomial 0xA001, reflected
+inline uint16_t _crc16_update(uint16_t crc, uint8_t a) {
+  crc ^= a;
+  for (uint8_t i = 0; i < 8; i++) crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : (crc >> 1);
+  return( crc );
+}
+
+#endif
@@ -0,0 +1,7 @@
+#ifndef host_delay_h
+#define host_delay_h
+
+#define _delay_ms(ms)
+#define _delay_us(us)
+
+#endif
@@ -0,0 +1,175 @@
+/*
+
+luxcheck: check the table-driven TSL2561::calculateLux() against the original
+if/else bracket cascade on a host, and time both.
+
+Build:   g++ -O2 -o luxcheck -I../host -I../../libraries/TSL2561 luxcheck.cpp ../../libraries/TSL2561/TSL2561.cpp ../host/host.cpp
+
+Usage:   luxcheck [-a] [-s step]
+
+  (default) every ch0, and ch1 in steps of 61, for each of the six gain
+            and integration settings
+  -a        all 2^32 (ch0, ch1) pairs per setting; about 8 minutes
+  -s step   ch1 in steps of this many
+
+The package is the one TSL2561.h selects.  Both versions run in the host's
+64-bit unsigned long, where the AVR has 32: the scaled channels don't wrap
+here as they can there, but they go through the same arithmetic on both
+sides, so a mismatch is the table's doing either way.  Exit status 1 on any
+mismatch, or if some bracket was never reached.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "TSL2561.h"
+
+// the calculateLux() this library shipped with
+static uint32_t referenceLux(uint16_t ch0, uint16_t ch1, tsl2561IntegrationTime_t integration, tsl2561Gain_t gain, int &bracket)
+{
+  unsigned long chScale;
+  unsigned long channel1;
+  unsigned long channel0;
+
+  switch (integration)
+  {
+    case TSL2561_INTEGRATIONTIME_13MS:
+      chScale = TSL2561_LUX_CHSCALE_TINT0;
+      break;
+    case TSL2561_INTEGRATIONTIME_101MS:
+      chScale = TSL2561_LUX_CHSCALE_TINT1;
+      break;
+    default:
+      chScale = (1 << TSL2561_LUX_CHSCALE);
+      break;
+  }
+  if (!gain) chScale = chScale << 4;
+
+  channel0 = (ch0 * chScale) >> TSL2561_LUX_CHSCALE;
+  channel1 = (ch1 * chScale) >> TSL2561_LUX_CHSCALE;
+
+  unsigned long ratio1 = 0;
+  if (channel0 != 0) ratio1 = (channel1 << (TSL2561_LUX_RATIOSCALE+1)) / channel0;
+  unsigned long ratio = (ratio1 + 1) >> 1;
+
+  unsigned int b, m;
+#ifdef TSL2561_PACKAGE_CS
+  if (ratio <= TSL2561_LUX_K1C)
+    {b=TSL2561_LUX_B1C; m=TSL2561_LUX_M1C; bracket=0;}
+  else if (ratio <= TSL2561_LUX_K2C)
+    {b=TSL2561_LUX_B2C; m=TSL2561_LUX_M2C; bracket=1;}
+  else if (ratio <= TSL2561_LUX_K3C)
+    {b=TSL2561_LUX_B3C; m=TSL2561_LUX_M3C; bracket=2;}
+  else if (ratio <= TSL2561_LUX_K4C)
+    {b=TSL2561_LUX_B4C; m=TSL2561_LUX_M4C; bracket=3;}
+  else if (ratio <= TSL2561_LUX_K5C)
+    {b=TSL2561_LUX_B5C; m=TSL2561_LUX_M5C; bracket=4;}
+  else if (ratio <= TSL2561_LUX_K6C)
+    {b=TSL2561_LUX_B6C; m=TSL2561_LUX_M6C; bracket=5;}
+  else if (ratio <= TSL2561_LUX_K7C)
+    {b=TSL2561_LUX_B7C; m=TSL2561_LUX_M7C; bracket=6;}
+  else
+    {b=TSL2561_LUX_B8C; m=TSL2561_LUX_M8C; bracket=7;}
+#else
+  if (ratio <= TSL2561_LUX_K1T)
+    {b=TSL2561_LUX_B1T; m=TSL2561_LUX_M1T; bracket=0;}
+  else if (ratio <= TSL2561_LUX_K2T)
+    {b=TSL2561_LUX_B2T; m=TSL2561_LUX_M2T; bracket=1;}
+  else if (ratio <= TSL2561_LUX_K3T)
+    {b=TSL2561_LUX_B3T; m=TSL2561_LUX_M3T; bracket=2;}
+  else if (ratio <= TSL2561_LUX_K4T)
+    {b=TSL2561_LUX_B4T; m=TSL2561_LUX_M4T; bracket=3;}
+  else if (ratio <= TSL2561_LUX_K5T)
+    {b=TSL2561_LUX_B5T; m=TSL2561_LUX_M5T; bracket=4;}
+  else if (ratio <= TSL2561_LUX_K6T)
+    {b=TSL2561_LUX_B6T; m=TSL2561_LUX_M6T; bracket=5;}
+  else if (ratio <= TSL2561_LUX_K7T)
+    {b=TSL2561_LUX_B7T; m=TSL2561_LUX_M7T; bracket=6;}
+  else
+    {b=TSL2561_LUX_B8T; m=TSL2561_LUX_M8T; bracket=7;}
+#endif
+
+  unsigned long temp = ((channel0 * b) - (channel1 * m));
+  temp += (1 << (TSL2561_LUX_LUXSCALE-1));
+  return temp >> TSL2561_LUX_LUXSCALE;
+}
+
+static double seconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static const tsl2561IntegrationTime_t timings[3] = {
+  TSL2561_INTEGRATIONTIME_13MS, TSL2561_INTEGRATIONTIME_101MS, TSL2561_INTEGRATIONTIME_402MS
+};
+static const tsl2561Gain_t gains[2] = { TSL2561_GAIN_0X, TSL2561_GAIN_16X };
+
+int main(int argc, char **argv) {
+  unsigned long step = 61;
+  int c;
+  while ( (c = getopt(argc, argv, "as:")) != -1 ) {
+    switch ( c ) {
+      case 'a': step = 1; break;
+      case 's': step = strtoul(optarg, 0, 10); break;
+      default:
+        fprintf(stderr, "usage: luxcheck [-a] [-s step]\n");
+        return 2;
+    }
+  }
+  if ( step == 0 ) step = 1;
+
+  TSL2561 tsl(TSL2561_ADDR_FLOAT);
+  unsigned long long checked = 0, mismatches = 0, hits[8] = { 0 };
+  for (int t = 0; t < 3; t++) {
+    for (int g = 0; g < 2; g++) {
+      tsl.setTiming(timings[t]);
+      tsl.setGain(gains[g]);
+      for (unsigned long ch0 = 0; ch0 < 65536UL; ch0++) {
+        for (unsigned long ch1 = 0; ch1 < 65536UL; ch1 += step) {
+          int bracket;
+          uint32_t a = tsl.calculateLux(ch0, ch1);
+          uint32_t b = referenceLux(ch0, ch1, timings[t], gains[g], bracket);
+          hits[bracket]++;
+          checked++;
+          if ( a != b && ++mismatches <= 10 ) {
+            printf("mismatch: timing %d gain %d ch0 %lu ch1 %lu: table %lu, reference %lu\n",
+                   t, g, ch0, ch1, (unsigned long)a, (unsigned long)b);
+          }
+        }
+      }
+    }
+  }
+  printf("%llu pairs checked, %llu mismatches\n", checked, mismatches);
+  boolean allHit = true;
+  for (int i = 0; i < 8; i++) {
+    printf("bracket %d: %llu\n", i + 1, hits[i]);
+    if ( !hits[i] ) allHit = false;
+  }
+
+  // timing: the same pseudo-random pairs through each, and the sums kept so
+  // neither loop is optimized away
+  const unsigned long n = 20000000UL;
+  uint32_t x = 1, sumA = 0, sumB = 0;
+  tsl.setTiming(TSL2561_INTEGRATIONTIME_101MS);
+  tsl.setGain(TSL2561_GAIN_16X);
+  double t0 = seconds();
+  for (unsigned long i = 0; i < n; i++) {
+    x = x * 1664525UL + 1013904223UL;
+    sumA += tsl.calculateLux(x >> 16, (x & 0xFFFF) >> 1);
+  }
+  double t1 = seconds();
+  x = 1;
+  for (unsigned long i = 0; i < n; i++) {
+    int bracket;
+    x = x * 1664525UL + 1013904223UL;
+    sumB += referenceLux(x >> 16, (x & 0xFFFF) >> 1, TSL2561_INTEGRATIONTIME_101MS, TSL2561_GAIN_16X, bracket);
+  }
+  double t2 = seconds();
+  printf("table %.2f ns/call, reference %.2f ns/call%s\n",
+         (t1 - t0) * 1e9 / n, (t2 - t1) * 1e9 / n, sumA == sumB ? "" : " (sums differ)");
+
+  return( mismatches || !allHit || sumA != sumB ? 1 : 0 );
+}
@@ -0,0 +1,133 @@
+/*
+
+pidcheck: run PID_Q16 and PID_Q8 (libraries/PID_v1/PID_fixed.h) next to the
+float PID on a host, on the same inputs, and check how far apart their outputs
+get.  Examples/PID_FixedBench times them on the board; host timings would say
+nothing about the AVR's soft float, so there are none here.
+
+Build:   g++ -O2 -o pidcheck -I../host -I../../libraries/PID_v1 pidcheck.cpp ../../libraries/PID_v1/PID_v1.cpp ../host/host.cpp
+
+Usage:   pidcheck [-n samples]
+
+  -n samples  per case (default 200000)
+
+Each case is a set of tunings, limits and a sample time, with the input a
+random walk over 0-1023 (an adc) and a new setpoint every 5000 samples.  The
+float PID is fed the same integers the fixed one is.  Q16 has to stay within
+one output unit of the float PID, or 0.1% of the output range where that is
+more (a small Ki * sample time, kept to 2^-16, leaves the integral that far
+off), or the exit status is 1.  Q8 is shown for comparison; its Ki * sample
+time is kept only to 1/256.
+
+long is 64 bits here and 32 on the AVR, so a case past PID_fixed.h's limit
+(each term below 2^(29-FRAC)) would pass here and overflow there; those are
+refused.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <unistd.h>
+#include "PID_v1.h"
+#include "PID_fixed.h"
+
+static long samples = 200000;
+
+struct Case {
+  double kp, ki, kd;
+  int direction;
+  long lo, hi;
+  int sampleTime;
+};
+
+static const Case cases[] = {
+  { 2, 0.5, 0.1, DIRECT, 0, 255, 100 },         // PID_Basic, a pwm output
+  { 0.1, 0.0002, 10, DIRECT, 0, 30, 30000 },    // gbot1219's pump window, in seconds
+  { 1, 0.2, 0.05, REVERSE, -1000, 1000, 100 },  // signed output, reverse acting
+  { 5, 1, 0, DIRECT, 0, 4000, 10 },             // PI, fast
+  { 0.5, 0.05, 2, DIRECT, 0, 5000, 1000 },      // a relay window in ms
+};
+
+// worst and mean |float - fixed| over a run
+template <uint8_t FRAC>
+static double run(const Case &c, double &mean) {
+  double din = 0, dout = 0, dsp = 0;
+  long fin = 0, fout = 0, fsp = 0;
+  hostMillis = 0;
+  PID d(&din, &dout, &dsp, c.kp, c.ki, c.kd, c.direction);
+  PIDFixed<FRAC> f(&fin, &fout, &fsp, c.kp, c.ki, c.kd, c.direction);
+  d.SetOutputLimits(c.lo, c.hi);
+  f.SetOutputLimits(c.lo, c.hi);
+  d.SetSampleTime(c.sampleTime);
+  f.SetSampleTime(c.sampleTime);
+  d.SetMode(AUTOMATIC);
+  f.SetMode(AUTOMATIC);
+
+  double worst = 0, sum = 0;
+  srand(7);
+  long in = 500, sp = 512;
+  for (long i = 0; i < samples; i++) {
+    hostMillis += c.sampleTime;
+    if ( i % 5000 == 0 ) sp = rand() % 1024;
+    in += rand() % 21 - 10;
+    if ( in < 0 ) in = 0;
+    if ( in > 1023 ) in = 1023;
+    din = in;
+    fin = in;
+    dsp = sp;
+    fsp = sp;
+    d.Compute();
+    f.Compute();
+    double e = fabs(dout - fout);
+    if ( e > worst ) worst = e;
+    sum += e;
+  }
+  mean = sum / samples;
+  return( worst );
+}
+
+// does the case fit in the AVR's 32-bit longs at FRAC?  the largest term is kp times an
+// error of the whole input range, or kd times a step of it, or the limits themselves
+static bool fits(const Case &c, int frac) {
+  double limit = ldexp(1, 29 - frac);
+  double kd = c.kd / (c.sampleTime / 1000.0);
+  return( fabs(c.lo) < limit && fabs(c.hi) < limit && c.kp * 1024 < limit && kd * 1024 < limit );
+}
+
+int main(int argc, char **argv) {
+  int ch;
+  while ( (ch = getopt(argc, argv, "n:")) != -1 ) {
+    switch ( ch ) {
+      case 'n': samples = strtol(optarg, 0, 10); break;
+      default:
+        fprintf(stderr, "usage: pidcheck [-n samples]\n");
+        return 2;
+    }
+  }
+  if ( samples < 1 ) samples = 1;
+
+  int failed = 0;
+  for (unsigned i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    const Case &c = cases[i];
+    printf("case %u: kp %g ki %g kd %g %s, output %ld..%ld, every %d ms\n", i + 1, c.kp, c.ki, c.kd,
+           c.direction == DIRECT ? "direct" : "reverse", c.lo, c.hi, c.sampleTime);
+    double mean;
+    if ( fits(c, 16) ) {
+      double worst = run<16>(c, mean);
+      double tolerance = (c.hi - c.lo) / 1000.0;
+      if ( tolerance < 1 ) tolerance = 1;
+      bool ok = worst <= tolerance;
+      if ( !ok ) failed++;
+      printf("  Q16: worst %.3f (allowed %.1f), mean %.4f%s\n", worst, tolerance, mean, ok ? "" : "  FAIL");
+    } else {
+      printf("  Q16: past 2^13 in output units; not run\n");
+    }
+    if ( fits(c, 8) ) {
+      double worst = run<8>(c, mean);
+      printf("  Q8:  worst %.3f, mean %.4f\n", worst, mean);
+    }
+  }
+  printf(failed ? "%d Q16 cases out of tolerance\n" : "Q16 within tolerance of the float PID in every case\n", failed);
+  return( failed ? 1 : 0 );
+}
@@ -0,0 +1,173 @@
+/*
+
+pumpsim: gbot1219's pump control on a soil model, on a host: the PID driving a
+time-proportioned window, as pumpCheck() does it, against the bang-bang
+relayCheck() it replaced.  Overshoot and water used for each.
+
+Build:   g++ -O2 -o pumpsim -I../host -I../../libraries/PID_v1 -I../../libraries/SensorStats pumpsim.cpp ../../libraries/PID_v1/PID_v1.cpp ../../libraries/SensorStats/SensorStats.cpp ../host/host.cpp
+
+Usage:   pumpsim [-h hours] [-g goal] [-s start] [-p kp] [-i ki] [-d kd]
+
+  -h hours  simulated time (default 12)
+  -g goal   moistGoal, in probe counts (default 200)
+  -s start  moisture at the start (default 120)
+  -p -i -d  PID tunings (default the sketch's, 0.1, 0.0002, 10)
+
+The soil: water from the pump lands near the surface and soaks down to the
+probe with a time constant of 100 s, and the root zone dries slowly toward
+50 counts.  The probe is read once a second through SensorStats with the
+sketch's EMA weight, and the loop is held up as the sketch's is: 250 ms for
+every other checkSensors() (the DHT read), 20 ms for the others, and 1 ms
+per pass (Alarm.delay(1)).  So the PID's own sample clock and the loop
+drift apart the way they do on the board.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "PID_v1.h"
+#include "SensorStats.h"
+
+#define PUMP_WINDOW 30000 // ms, as the sketch
+#define MIN_PUMP_CYCLE 5  // s, minPumpCycleTime
+
+static unsigned long hours = 12;
+static int goal = 200, start = 120;
+static double kp = 0.1, ki = 0.0002, kd = 10;
+
+struct Soil {
+  double surface, root;
+};
+
+// one second, with the pump on for onMs of it
+static void soilStep(Soil &z, unsigned long onMs) {
+  z.surface += 2.0 * onMs / 1000;
+  double f = z.surface * 0.01;
+  z.surface -= f;
+  z.root += f;
+  z.root -= (z.root - 50) * 0.0001;
+}
+
+struct Result {
+  double overshoot;     // counts above the goal, at most, once it was reached
+  double settled;       // mean error over the last hour
+  unsigned long pumpMs; // water used, as pump time
+  unsigned long starts; // pump starts
+  unsigned long shortest; // shortest run, ms
+};
+
+static Result run(boolean pid) {
+  Soil z = { 0, (double)start };
+  SensorStats moistStats(3);
+  Result r = { 0, 0, 0, 0, 0xFFFFFFFFUL };
+
+  hostMillis = 0;
+  double moistInput, moistSetpoint, pumpOnTime = 0;
+  PID moistPID(&moistInput, &pumpOnTime, &moistSetpoint, kp, ki, kd, DIRECT);
+  moistPID.SetOutputLimits(0, PUMP_WINDOW / 1000);
+  moistPID.SetSampleTime(PUMP_WINDOW);
+  moistStats.update((long)z.root);
+  long moistNew = moistStats.getEMA();
+  moistInput = moistNew;
+  moistSetpoint = goal;
+  moistPID.SetMode(AUTOMATIC);
+
+  unsigned long end = hours * 3600000UL;
+  unsigned long nextSensor = 1000, nextRelay = 5000, sensorCalls = 0;
+  unsigned long pumpWindowStart = 0, pumpWindowOn = 0;
+  boolean pumpOn = false, reached = false;
+  unsigned long onSince = 0, onThisSecond = 0;
+  double errSum = 0;
+  unsigned long errN = 0;
+
+  while ( hostMillis < end ) {
+    unsigned long t = hostMillis;
+    unsigned long busy = 1; // Alarm.delay(1)
+
+    // checkSensors(), once a second
+    if ( t >= nextSensor ) {
+      nextSensor += 1000;
+      moistStats.update((long)z.root);
+      moistNew = moistStats.getEMA();
+      busy += (sensorCalls++ & 1) ? 250 : 20;
+    }
+
+    boolean on = pumpOn;
+    if ( pid ) {
+      // pumpCheck()
+      moistInput = moistNew;
+      moistSetpoint = goal;
+      if ( moistPID.Compute() ) {
+        pumpWindowStart = t;
+        pumpWindowOn = pumpOnTime * 1000;
+        if ( pumpWindowOn < MIN_PUMP_CYCLE * 1000UL ) pumpWindowOn = 0;
+        if ( pumpWindowOn > PUMP_WINDOW - MIN_PUMP_CYCLE * 1000UL ) pumpWindowOn = PUMP_WINDOW;
+      }
+      on = ( pumpWindowOn >= PUMP_WINDOW || t - pumpWindowStart < pumpWindowOn );
+    } else if ( t >= nextRelay ) {
+      // the old relayCheck(), every 5 s
+      nextRelay += 5000;
+      on = moistNew < goal;
+    }
+
+    if ( on != pumpOn ) {
+      if ( on ) {
+        r.starts++;
+        onSince = t;
+      } else if ( t - onSince < r.shortest ) {
+        r.shortest = t - onSince;
+      }
+      pumpOn = on;
+    }
+
+    // the time the pass took, a millisecond at a time
+    for (unsigned long i = 0; i < busy && hostMillis < end; i++) {
+      if ( pumpOn ) {
+        onThisSecond++;
+        r.pumpMs++;
+      }
+      hostMillis++;
+      if ( hostMillis % 1000 == 0 ) {
+        soilStep(z, onThisSecond);
+        onThisSecond = 0;
+        if ( z.root >= goal ) reached = true;
+        if ( reached && z.root - goal > r.overshoot ) r.overshoot = z.root - goal;
+        if ( hostMillis > end - 3600000UL ) {
+          errSum += z.root - goal;
+          errN++;
+        }
+      }
+    }
+  }
+  if ( errN ) r.settled = errSum / errN;
+  if ( r.starts == 0 ) r.shortest = 0;
+  return( r );
+}
+
+static void report(const char *name, const Result &r) {
+  printf("%-10s overshoot %6.1f counts, last hour off by %6.1f, pump %6lu s in %4lu starts, shortest run %5.1f s\n",
+         name, r.overshoot, r.settled, r.pumpMs / 1000, r.starts, r.shortest / 1000.0);
+}
+
+int main(int argc, char **argv) {
+  int c;
+  while ( (c = getopt(argc, argv, "h:g:s:p:i:d:")) != -1 ) {
+    switch ( c ) {
+      case 'h': hours = strtoul(optarg, 0, 10); break;
+      case 'g': goal = atoi(optarg); break;
+      case 's': start = atoi(optarg); break;
+      case 'p': kp = atof(optarg); break;
+      case 'i': ki = atof(optarg); break;
+      case 'd': kd = atof(optarg); break;
+      default:
+        fprintf(stderr, "usage: pumpsim [-h hours] [-g goal] [-s start] [-p kp] [-i ki] [-d kd]\n");
+        return 2;
+    }
+  }
+  if ( hours < 2 ) hours = 2;
+
+  report("bang-bang", run(false));
+  report("pid", run(true));
+  return 0;
+}
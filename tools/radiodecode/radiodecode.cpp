@@ -0,0 +1,307 @@
+/*
+
+radiodecode: run the RadioRx decoder on a host, next to a plain reference
+decoder, and check that they agree.
+
+Build:   g++ -O2 -o radiodecode -I../../libraries/RadioRx radiodecode.cpp ../../libraries/RadioRx/RadioRx.cpp
+Capture: send "l" to GardenBot_v1 and save its serial output, or export pulse
+         times from a logic analyzer or SDR.
+
+Usage:   radiodecode [-v] [-s frames] [-r seed] [file]
+
+  -v         one line per frame: who decoded it, and the value
+  -s frames  instead of reading captures, synthesize this many frames of
+             TB304BC and Etekcity outlets, with jitter, per-sender clock drift,
+             noise between them, and the odd broken pulse; and check both
+             decoders against what was sent
+  -r seed    for -s
+
+Input is as for radiosniff: lines holding "raw:" are one capture each (the
+sketch's "Sniff raw:" lines), starting with a LOW gap; other lines of nothing
+but numbers are a stream of edge times, alternately LOW and HIGH, starting
+with a LOW, in us.  Everything else is skipped.
+
+The reference decoder is the protocol tables read literally: a sync is a LOW
+within RADIORX_SLOP of spec; the pulse length is the sync gap over its
+pulses; a bit is the symbol whose HIGH and LOW are both within RADIORX_TOL
+of n pulses, in exact arithmetic.  RadioRx gets the same answer with table
+lookups, in quantized time, and keeps a learned sync window; so the two can
+part at the edges of a window, but rarely.  Repeats aren't dropped here, so
+every frame counts.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+#include "RadioRx.h"
+
+static const RadioProtocol protocols[] = { RADIO_TB304BC, RADIO_ETEK };
+#define NPROT (sizeof(protocols) / sizeof(protocols[0]))
+
+static bool verbose = false;
+
+// a decoded frame: protocol, value, and the edge it ended on
+struct Frame {
+  int prot;
+  unsigned long val;
+  unsigned long at;
+};
+
+// the reference decoder
+class Reference {
+  public:
+    Reference() {
+      for (unsigned p = 0; p < NPROT; p++) inFrame[p] = false;
+    }
+
+    void edge(unsigned long t, int level, unsigned long at, std::vector<Frame> &out) {
+      for (unsigned p = 0; p < NPROT; p++) {
+        const RadioProtocol &r = protocols[p];
+        if ( level == 1 ) {
+          // a LOW just ended
+          if ( inFrame[p] ) {
+            int b = bit(r, unit[p], high[p], t);
+            if ( b < 0 ) inFrame[p] = false;
+            else {
+              val[p] = (val[p] << 1) | b;
+              n[p]++;
+            }
+          }
+          if ( !inFrame[p] ) {
+            double spec = (double)r.pulseLength * r.sync[1];
+            if ( t >= spec * 100 / RADIORX_SLOP && t <= spec * RADIORX_SLOP / 100 ) {
+              inFrame[p] = true;
+              unit[p] = (double)t / r.sync[1];
+              val[p] = 0;
+              n[p] = 0;
+            }
+          }
+        } else if ( inFrame[p] ) {
+          high[p] = t;
+          if ( n[p] >= r.bits ) {
+            Frame f = { (int)p, val[p], at };
+            out.push_back(f);
+            inFrame[p] = false;
+          }
+        }
+      }
+    }
+
+  private:
+    bool inFrame[NPROT];
+    double unit[NPROT];
+    unsigned long high[NPROT], val[NPROT];
+    unsigned n[NPROT];
+
+    static bool within(double t, double unit, int n) {
+      double w = unit * n;
+      double tol = w / (1 << RADIORX_TOL_SHIFT);
+      if ( tol < unit / 2 ) tol = unit / 2;
+      return t >= w - tol && t <= w + tol;
+    }
+
+    // 1, 0, or -1 for neither
+    static int bit(const RadioProtocol &r, double unit, unsigned long h, unsigned long l) {
+      if ( within(h, unit, r.one[0]) && within(l, unit, r.one[1]) ) return 1;
+      if ( within(h, unit, r.zero[0]) && within(l, unit, r.zero[1]) ) return 0;
+      return -1;
+    }
+};
+
+static RadioChannel channels[NPROT];
+static RadioRx rx;
+static Reference ref;
+static unsigned long edges = 0, nowUs = 0;
+
+// one edge into both
+static void edge(unsigned long t, int level, std::vector<Frame> &lib, std::vector<Frame> &refOut) {
+  nowUs += t;
+  edges++;
+  rx.edge(t, level, nowUs / 1000);
+  if ( rx.available() ) {
+    Frame f = { rx.protocol(), rx.message(), edges };
+    lib.push_back(f);
+    rx.clear();
+  }
+  ref.edge(t, level, edges, refOut);
+}
+
+// the frames both found, or one alone; matched in order, by protocol and value
+static void compare(const std::vector<Frame> &lib, const std::vector<Frame> &refOut,
+                    unsigned long &both, unsigned long &libOnly, unsigned long &refOnly) {
+  size_t i = 0, j = 0;
+  while ( i < lib.size() || j < refOut.size() ) {
+    if ( i < lib.size() && j < refOut.size() && lib[i].at == refOut[j].at &&
+         lib[i].prot == refOut[j].prot && lib[i].val == refOut[j].val ) {
+      if ( verbose ) printf("both: protocol %d %lu (0x%lx)\n", lib[i].prot, lib[i].val, lib[i].val);
+      both++;
+      i++;
+      j++;
+    } else if ( j == refOut.size() || (i < lib.size() && lib[i].at <= refOut[j].at) ) {
+      if ( verbose ) printf("RadioRx only: protocol %d %lu (0x%lx)\n", lib[i].prot, lib[i].val, lib[i].val);
+      libOnly++;
+      i++;
+    } else {
+      if ( verbose ) printf("reference only: protocol %d %lu (0x%lx)\n", refOut[j].prot, refOut[j].val, refOut[j].val);
+      refOnly++;
+      j++;
+    }
+  }
+}
+
+// numbers on a line; false if there's anything else on it
+static bool numbers(const char *s, std::vector<unsigned long> &out) {
+  out.clear();
+  while ( *s ) {
+    if ( *s == '-' || *s == '+' || *s == ',' || *s == ' ' || *s == '\t' || *s == '\r' || *s == '\n' ) {
+      s++;
+      continue;
+    }
+    if ( *s < '0' || *s > '9' ) return false;
+    char *end;
+    out.push_back(strtoul(s, &end, 10));
+    s = end;
+  }
+  return true;
+}
+
+static double uniform(double lo, double hi) {
+  return lo + (hi - lo) * (rand() / (RAND_MAX + 1.0));
+}
+
+// a time, with jitter
+static unsigned long jitter(double t) {
+  return (unsigned long)(t * uniform(0.92, 1.08) + 0.5);
+}
+
+static void synthesize(unsigned long frames) {
+  std::vector<Frame> sent, lib, refOut;
+  // a few senders per protocol, each with its own clock
+  const int senders = 3;
+  double drift[NPROT][senders];
+  unsigned long code[NPROT][senders];
+  for (unsigned p = 0; p < NPROT; p++) {
+    for (int s = 0; s < senders; s++) {
+      drift[p][s] = uniform(0.9, 1.1);
+      code[p][s] = ((unsigned long)rand() << 16 ^ rand()) & (protocols[p].bits < 32 ? (1UL << protocols[p].bits) - 1 : 0xFFFFFFFFUL);
+    }
+  }
+  unsigned long broken = 0;
+  for (unsigned long f = 0; f < frames; f++) {
+    int p = rand() % NPROT, s = rand() % senders;
+    const RadioProtocol &r = protocols[p];
+    double unit = r.pulseLength * drift[p][s];
+
+    // the pin is LOW.  noise between frames: short LOWs and HIGHs
+    int k = rand() % 12;
+    for (int i = 0; i < 2 * k; i++) edge(jitter(uniform(100, 3000)), (i & 1) == 0, lib, refOut);
+    // a last gap, then the sync, the bits, and the trailing HIGH
+    edge(jitter(uniform(100, 3000)), 1, lib, refOut);
+    edge(jitter(unit * r.sync[0]), 0, lib, refOut);
+    edge(jitter(unit * r.sync[1]), 1, lib, refOut);
+    bool bad = rand() % 20 == 0;
+    int badBit = rand() % r.bits;
+    for (int b = r.bits - 1; b >= 0; b--) {
+      const byte *seq = (code[p][s] >> b) & 1 ? r.one : r.zero;
+      double h = unit * seq[0];
+      if ( bad && b == badBit ) h = unit * 2.2; // a pulse no symbol has
+      edge(jitter(h), 0, lib, refOut);
+      edge(jitter(unit * seq[1]), 1, lib, refOut);
+    }
+    edge(jitter(unit * r.sync[0]), 0, lib, refOut);
+    if ( bad ) broken++;
+    else {
+      Frame fr = { p, code[p][s], edges };
+      sent.push_back(fr);
+    }
+  }
+  // a last gap, in case
+  edge(20000, 1, lib, refOut);
+
+  // against what was sent
+  unsigned long libGood = 0, refGood = 0;
+  size_t i = 0;
+  for (size_t j = 0; j < lib.size(); j++) {
+    while ( i < sent.size() && sent[i].at < lib[j].at ) i++;
+    if ( i < sent.size() && sent[i].at == lib[j].at && sent[i].prot == lib[j].prot && sent[i].val == lib[j].val ) libGood++;
+  }
+  i = 0;
+  for (size_t j = 0; j < refOut.size(); j++) {
+    while ( i < sent.size() && sent[i].at < refOut[j].at ) i++;
+    if ( i < sent.size() && sent[i].at == refOut[j].at && sent[i].prot == refOut[j].prot && sent[i].val == refOut[j].val ) refGood++;
+  }
+  printf("%lu frames sent, %lu broken on purpose\n", sent.size() + broken, broken);
+  printf("RadioRx: %lu decoded, %lu of %lu good ones right\n", (unsigned long)lib.size(), libGood, (unsigned long)sent.size());
+  printf("reference: %lu decoded, %lu of %lu good ones right\n", (unsigned long)refOut.size(), refGood, (unsigned long)sent.size());
+
+  unsigned long both = 0, libOnly = 0, refOnly = 0;
+  compare(lib, refOut, both, libOnly, refOnly);
+  printf("agree on %lu; RadioRx alone %lu, reference alone %lu\n", both, libOnly, refOnly);
+  for (unsigned p = 0; p < NPROT; p++) {
+    RadioStats st;
+    rx.getStats(p, st);
+    printf("RadioRx protocol %u: syncs %u frames %u bad HIGH %u bad LOW %u unit %u us\n",
+           p, st.syncs, st.frames, st.badHigh, st.badLow, rx.getUnit(p));
+  }
+}
+
+int main(int argc, char **argv) {
+  unsigned long frames = 0;
+  int c;
+  while ( (c = getopt(argc, argv, "vs:r:")) != -1 ) {
+    switch ( c ) {
+      case 'v': verbose = true; break;
+      case 's': frames = strtoul(optarg, 0, 10); break;
+      case 'r': srand(strtoul(optarg, 0, 10)); break;
+      default:
+        fprintf(stderr, "usage: radiodecode [-v] [-s frames] [-r seed] [file]\n");
+        return 2;
+    }
+  }
+
+  rx.begin(protocols, channels, NPROT);
+  rx.setRepeat(0);
+
+  if ( frames ) {
+    synthesize(frames);
+    return 0;
+  }
+
+  if ( argc - optind > 1 ) {
+    fprintf(stderr, "usage: radiodecode [-v] [-s frames] [-r seed] [file]\n");
+    return 2;
+  }
+  FILE *in = stdin;
+  if ( optind < argc && !(in = fopen(argv[optind], "rb")) ) {
+    perror(argv[optind]);
+    return 1;
+  }
+
+  std::vector<Frame> lib, refOut;
+  std::vector<unsigned long> nums;
+  int level = 1; // the stream starts with a LOW, so its end is a rise
+  char *line = 0;
+  size_t cap = 0;
+  while ( getline(&line, &cap, in) > 0 ) {
+    const char *raw = strstr(line, "raw:");
+    if ( raw ) {
+      if ( !numbers(raw + 4, nums) ) continue;
+      for (size_t i = 0; i < nums.size(); i++) edge(nums[i], (i & 1) == 0, lib, refOut);
+      continue;
+    }
+    if ( !numbers(line, nums) ) continue;
+    for (size_t i = 0; i < nums.size(); i++) {
+      edge(nums[i], level, lib, refOut);
+      level = !level;
+    }
+  }
+  free(line);
+
+  unsigned long both = 0, libOnly = 0, refOnly = 0;
+  compare(lib, refOut, both, libOnly, refOnly);
+  printf("%lu edges. agree on %lu frames; RadioRx alone %lu, reference alone %lu\n", edges, both, libOnly, refOnly);
+  return libOnly || refOnly ? 1 : 0;
+}
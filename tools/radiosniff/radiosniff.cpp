@@ -0,0 +1,132 @@
+/*
+
+radiosniff: learn 433 MHz protocols and codes from raw edge captures on a host,
+with the same RadioSniff code GardenBot_v1's learning mode runs.
+
+Build:   g++ -O2 -o radiosniff -I../../libraries/RadioSniff radiosniff.cpp ../../libraries/RadioSniff/RadioSniff.cpp
+Capture: send "l" to GardenBot_v1 and save its serial output, or export pulse
+         times from a logic analyzer or SDR.
+
+Usage:   radiosniff [-v] [-g gap] [file]
+
+  -v        one line per capture: its protocol and code, or why not
+  -g gap    us; a LOW at least this long starts and ends a frame (default 5000,
+            as RADIO_SNIFF_GAP)
+
+Lines holding "raw:" are one capture each, the numbers after it (the sketch's
+"Sniff raw:" lines).  Other lines of nothing but numbers are a stream of edge
+times, alternately HIGH and LOW, in us; a sign is ignored.  The stream is cut
+into captures at the long LOW gaps.  Everything else is skipped.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+#include "RadioSniff.h"
+
+static bool verbose = false;
+static unsigned long gapMin = 5000;
+static RadioSniff sniffer;
+static unsigned long captures = 0, tooLong = 0;
+
+static void usage() {
+  fprintf(stderr, "usage: radiosniff [-v] [-g gap] [file]\n");
+  exit(2);
+}
+
+static void capture(const std::vector<unsigned int> &e) {
+  captures++;
+  if ( e.size() > 255 ) {
+    tooLong++;
+    if ( verbose ) printf("capture %lu: %u edges, too long\n", captures, (unsigned)e.size());
+    return;
+  }
+  int c = sniffer.add(&e[0], e.size());
+  if ( !verbose ) return;
+  if ( c < 0 ) {
+    printf("capture %lu: %u edges, not a frame\n", captures, (unsigned)e.size());
+  } else {
+    const SniffCode &code = sniffer.getCode(c);
+    printf("capture %lu: protocol %u code %lu (0x%lx)\n", captures, code.protocol, code.code, code.code);
+  }
+}
+
+// numbers on a line; false if there's anything else on it
+static bool numbers(const char *s, std::vector<unsigned int> &out) {
+  out.clear();
+  while ( *s ) {
+    if ( *s == '-' || *s == '+' || *s == ',' || *s == ' ' || *s == '\t' || *s == '\r' || *s == '\n' ) {
+      s++;
+      continue;
+    }
+    if ( *s < '0' || *s > '9' ) return false;
+    char *end;
+    out.push_back(strtoul(s, &end, 10));
+    s = end;
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  int c;
+  while ( (c = getopt(argc, argv, "vg:")) != -1 ) {
+    switch ( c ) {
+      case 'v': verbose = true; break;
+      case 'g': gapMin = strtoul(optarg, 0, 10); break;
+      default: usage();
+    }
+  }
+  if ( argc - optind > 1 ) usage();
+  FILE *in = stdin;
+  if ( optind < argc && !(in = fopen(argv[optind], "rb")) ) {
+    perror(argv[optind]);
+    return 1;
+  }
+
+  // the stream: edges since the last long gap, and whether the next edge is a LOW
+  std::vector<unsigned int> frame, nums;
+  bool started = false, low = false;
+
+  char *line = 0;
+  size_t cap = 0;
+  while ( getline(&line, &cap, in) > 0 ) {
+    const char *raw = strstr(line, "raw:");
+    if ( raw ) {
+      if ( numbers(raw + 4, nums) && !nums.empty() ) capture(nums);
+      continue;
+    }
+    if ( !numbers(line, nums) ) continue;
+    for ( size_t i = 0; i < nums.size(); i++ ) {
+      unsigned int t = nums[i];
+      // the first long time has to be a LOW; the levels alternate from there
+      if ( !started ) {
+        if ( t < gapMin ) continue;
+        started = true;
+        low = true;
+      }
+      frame.push_back(t);
+      if ( low && t >= gapMin ) {
+        if ( frame.size() > 1 ) capture(frame);
+        frame.assign(1, t);
+      }
+      low = !low;
+    }
+  }
+  free(line);
+
+  for ( byte i = 0; i < sniffer.getProtocols(); i++ ) {
+    const SniffProtocol &p = sniffer.getProtocol(i);
+    printf("protocol %u, from %u frames. As a RadioProtocol:\n", i, p.frames);
+    printf("  { %u, %u, { %u, %u }, { %u, %u }, { %u, %u } }\n",
+           p.bits, p.pulseLength, p.sync[0], p.sync[1], p.zero[0], p.zero[1], p.one[0], p.one[1]);
+  }
+  for ( byte i = 0; i < sniffer.getCodes(); i++ ) {
+    const SniffCode &code = sniffer.getCode(i);
+    printf("protocol %u code %lu (0x%lx) seen %u\n", code.protocol, code.code, code.code, code.count);
+  }
+  printf("%lu captures, %u not frames, %lu too long\n", captures, sniffer.getRejected(), tooLong);
+  return 0;
+}
@@ -0,0 +1,166 @@
+/*
+
+regcheck: load registry images in older layouts with GardenBot_v1's
+registryBegin() on a host, and check that each entry comes through: the
+fields both layouts know unchanged, the new ones 0.  And that the images it
+should refuse are refused.
+
+Build:   g++ -O2 -Wno-int-to-pointer-cast -o regcheck -I../host -I../../GardenBot_v1 regcheck.cpp ../../GardenBot_v1/Registry.cpp ../host/host.cpp
+
+Usage:   regcheck
+
+An older layout is told apart by its header: the size of its entries and the
+room it has for them.  Entries only grow at the end, so an older entry is the
+first bytes of one of ours; each image here is our entries cut to the stated
+size, packed as the header says, with its CRC.  The entries are bigger here
+than on the AVR (unsigned long is 64 bits), so the host EEPROM is 2 KB, but
+registryBegin() only goes by the sizes in the header either way.  Exit
+status 1 on any failure.
+
+*/
+
+#include <stdio.h>
+#include <stddef.h>
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+#include "Registry.h"
+
+struct Layout {
+  const char *what;
+  byte sensorSize, pumpSize;
+  byte maxSensors, maxPumps;
+  byte nSensors, nPumps;
+  byte badPump;   // bed 0 watered by pump nPumps
+  boolean loads;  // should registryBegin() take it?
+};
+
+static const Layout layouts[] = {
+  { "this layout, full", sizeof(SensorEntry), sizeof(PumpEntry), MAX_SENSORS, MAX_PUMPS, MAX_SENSORS, MAX_PUMPS, false, true },
+  { "room for 4 beds (version 1)", sizeof(SensorEntry), sizeof(PumpEntry), 4, MAX_PUMPS, 4, 2, false, true },
+  { "beds without a pump", offsetof(SensorEntry, pump), sizeof(PumpEntry), MAX_SENSORS, MAX_PUMPS, MAX_SENSORS, 1, false, true },
+  { "beds without targets or a pump", offsetof(SensorEntry, minMoist), sizeof(PumpEntry), MAX_SENSORS, MAX_PUMPS, MAX_SENSORS, 1, false, true },
+  { "pumps without pulse/soak", sizeof(SensorEntry), offsetof(PumpEntry, pulsed), MAX_SENSORS, MAX_PUMPS, MAX_SENSORS, MAX_PUMPS, false, true },
+  { "all of those, room for 8 beds and 2 pumps", offsetof(SensorEntry, pump), offsetof(PumpEntry, pulsed), 8, 2, 8, 1, false, true },
+  { "bigger beds", sizeof(SensorEntry) + 1, sizeof(PumpEntry), MAX_SENSORS, MAX_PUMPS, 2, 1, false, false },
+  { "room for more beds", sizeof(SensorEntry), sizeof(PumpEntry), MAX_SENSORS + 8, MAX_PUMPS, 2, 1, false, false },
+  { "a bed watered by a missing pump", sizeof(SensorEntry), sizeof(PumpEntry), MAX_SENSORS, MAX_PUMPS, 3, 2, true, false },
+};
+
+// entry i as this sketch would have written it, in full
+static void sensorAt(byte i, const Layout &l, SensorEntry &e) {
+  memset(&e, 0, sizeof(e));
+  snprintf(e.name, sizeof(e.name), "Bed %d", i);
+  e.code = 910207744UL + i;
+  e.minMoist = 3 + i % 4;
+  e.maxMoist = 8 + i % 4;
+  e.pump = (l.badPump && i == 0) ? l.nPumps : i % l.nPumps;
+}
+
+static void pumpAt(byte i, PumpEntry &e) {
+  memset(&e, 0, sizeof(e));
+  snprintf(e.name, sizeof(e.name), "Pump %d", i + 1);
+  e.onCode = 1381683UL + 144 * i;
+  e.offCode = e.onCode + 9;
+  e.pulsed = i & 1;
+  e.pulseSec = 60 + i;
+  e.soakMin = 10 + i;
+  e.minPulseSec = 20;
+  e.maxPulseSec = 300;
+}
+
+// an image in layout l, its entries cut to its sizes.  false if it doesn't fit.
+static boolean write(const Layout &l) {
+  memset(hostEeprom, 0xFF, sizeof(hostEeprom));
+  RegistryHeader h = { REGISTRY_MAGIC, 1, l.sensorSize, l.pumpSize, l.maxSensors, l.maxPumps, l.nSensors, l.nPumps };
+  unsigned int at = REGISTRY_ADDR;
+  memcpy(hostEeprom + at, &h, sizeof(h));
+  at += sizeof(h);
+  // bytes past sizeof(SensorEntry), for the bigger layout, are left 0
+  byte buf[64];
+  for (byte i = 0; i < l.maxSensors; i++, at += l.sensorSize) {
+    memset(buf, 0, sizeof(buf));
+    if ( i < l.nSensors ) sensorAt(i, l, *(SensorEntry *)buf);
+    memcpy(hostEeprom + at, buf, l.sensorSize);
+  }
+  for (byte i = 0; i < l.maxPumps; i++, at += l.pumpSize) {
+    memset(buf, 0, sizeof(buf));
+    if ( i < l.nPumps ) pumpAt(i, *(PumpEntry *)buf);
+    memcpy(hostEeprom + at, buf, l.pumpSize);
+  }
+  if ( at + 2 > E2END + 1 ) return ( false );
+  uint16_t c = 0xFFFF;
+  for (unsigned int i = REGISTRY_ADDR; i < at; i++) c = _crc16_update(c, hostEeprom[i]);
+  memcpy(hostEeprom + at, &c, 2);
+  return ( true );
+}
+
+// the first keep bytes of want, the rest 0, against got
+static int compare(const void *got, const void *want, byte size, byte keep) {
+  byte cut[64];
+  memset(cut, 0, sizeof(cut));
+  memcpy(cut, want, keep < size ? keep : size);
+  return ( memcmp(got, cut, size) != 0 );
+}
+
+static int check(const Layout &l) {
+  if ( !write(l) ) {
+    printf("%s: image too big for the EEPROM\n", l.what);
+    return ( 1 );
+  }
+  RegistryHeader h;
+  boolean loaded = registryBegin(h);
+  if ( loaded != l.loads ) {
+    printf("%s: registryBegin() %s it  FAIL\n", l.what, loaded ? "took" : "refused");
+    return ( 1 );
+  }
+  if ( !loaded ) {
+    printf("%s: refused\n", l.what);
+    return ( 0 );
+  }
+
+  int bad = 0;
+  for (byte i = 0; i < l.nSensors; i++) {
+    SensorEntry got, want;
+    registryGet(i, got);
+    sensorAt(i, l, want);
+    if ( compare(&got, &want, sizeof(got), l.sensorSize) ) {
+      if ( bad++ < 5 ) printf("  bed %d: got %s, code %lu, %d-%d, pump %d\n", i, got.name, got.code, got.minMoist, got.maxMoist, got.pump);
+    }
+  }
+  for (byte i = 0; i < l.nPumps; i++) {
+    PumpEntry got, want;
+    registryGet(i, got);
+    pumpAt(i, want);
+    if ( compare(&got, &want, sizeof(got), l.pumpSize) ) {
+      if ( bad++ < 5 ) printf("  pump %d: got %s, codes %lu %lu\n", i, got.name, got.onCode, got.offCode);
+    }
+  }
+  // moved and resealed in this layout, so it loads as is next time
+  RegistryHeader again;
+  if ( !registryBegin(again) || again.sensorSize != sizeof(SensorEntry) || again.pumpSize != sizeof(PumpEntry) ||
+       again.maxSensors != MAX_SENSORS || again.maxPumps != MAX_PUMPS ||
+       again.nSensors != l.nSensors || again.nPumps != l.nPumps ) {
+    printf("  not resealed in this layout\n");
+    bad++;
+  }
+  printf("%s: %d beds, %d pumps, %d wrong%s\n", l.what, l.nSensors, l.nPumps, bad, bad ? "  FAIL" : "");
+  return ( bad ? 1 : 0 );
+}
+
+int main() {
+  int failed = 0;
+  for (unsigned i = 0; i < sizeof(layouts) / sizeof(layouts[0]); i++) failed += check(layouts[i]);
+
+  // and the ones that were never a registry
+  RegistryHeader h;
+  write(layouts[0]);
+  hostEeprom[REGISTRY_ADDR + 100] ^= 4;
+  boolean corrupt = registryBegin(h);
+  memset(hostEeprom, 0xFF, sizeof(hostEeprom));
+  boolean blank = registryBegin(h);
+  printf("a bad CRC: %s\nblank: %s\n", corrupt ? "took it  FAIL" : "refused", blank ? "took it  FAIL" : "refused");
+  failed += corrupt + blank;
+
+  printf(failed ? "%d checks failed\n" : "every layout loads as it should\n", failed);
+  return ( failed ? 1 : 0 );
+}
@@ -0,0 +1,28 @@
+#ifndef rtccheck_Wire_h
+#define rtccheck_Wire_h
+
+#include "Arduino.h"
+
+// a DS3231 on the bus: its time registers count from rtcStart (seconds of day), with the
+// first tick rtcPhase ms after millis() 0 and rtcRate chip ms per millis() ms.  writes go nowhere.
+extern long rtcStart;
+extern double rtcPhase, rtcRate;
+extern unsigned long rtcReads;
+
+class TwoWire {
+  public:
+    void begin() {}
+    void beginTransmission(uint8_t) {}
+    byte endTransmission() { return( 0 ); }
+    byte requestFrom(uint8_t, uint8_t n);
+    size_t write(uint8_t) { return( 1 ); }
+    int read() { return( next < 7 ? regs[next++] : 0 ); }
+
+  private:
+    byte regs[7];
+    byte next;
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,146 @@
+/*
+
+rtccheck: run DS3231::getCachedTime() against a simulated chip on a host, and
+check that the time it gives is never ahead of the chip's, how far behind it
+runs, and how often it goes to the bus.
+
+Build:   g++ -O2 -o rtccheck -I. -I../host -I../../libraries/DS3231 rtccheck.cpp ../../libraries/DS3231/DS3231.cpp
+
+Usage:   rtccheck [-h hours] [-r seed]
+
+  -h hours  simulated per case (default 2)
+  -r seed   for the chip's phase and the gaps between calls
+
+The chip (Wire.h here, in place of ../host's) ticks with a random phase
+against millis(), and in some cases 0.5% fast or slow of it, as a resonator
+clocked Arduino runs off from a crystal.  The sketch side calls
+getCachedTime() with random gaps: a busy loop (1-20 ms), a slow one (up to
+300 ms) and a once-a-second log.  The first 10 s of each case, while it homes
+in on the tick, are left out of the figures.  Exit status 1 if the time is
+ever ahead of the chip, or ms is ever past 999, or once homed in it still
+shows a second longer after the chip has gone on to the next than the case
+allows: 30 ms for the busy loop, 100 for the slow one.  How
+far ms runs behind is shown, not checked: it can only home in on the tick as
+fast as calls land near it, and calls exactly a second apart never do.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "DS3231.h"
+
+unsigned long hostMillis = 0;
+TwoWire Wire;
+
+long rtcStart;
+double rtcPhase, rtcRate;
+unsigned long rtcReads;
+
+static byte bcd(int v) {
+  return( (v / 10) << 4 | (v % 10) );
+}
+
+// the chip, in ms since midnight of day 1
+static double chipMs(unsigned long m) {
+  return( rtcStart * 1000.0 + rtcPhase + m * rtcRate );
+}
+
+// the time registers, latched as the read starts
+byte TwoWire::requestFrom(uint8_t, uint8_t n) {
+  long s = (long)(chipMs(hostMillis) / 1000);
+  long day = s / 86400;
+  s %= 86400;
+  regs[0] = bcd(s % 60);
+  regs[1] = bcd(s / 60 % 60);
+  regs[2] = bcd(s / 3600);
+  regs[3] = bcd(1 + day % 7);
+  regs[4] = bcd(1 + day);
+  regs[5] = bcd(1);
+  regs[6] = bcd(15);
+  next = 0;
+  rtcReads++;
+  return( n );
+}
+
+struct Case {
+  const char *what;
+  double rate;
+  unsigned int gapMin, gapMax; // ms between calls
+  long start;                  // s since midnight
+  long late;                   // ms, at most
+};
+
+// the further apart the calls, the less each read can narrow down the tick
+static const Case cases[] = {
+  { "busy loop", 1.0, 1, 20, 3600, 30 },
+  { "busy loop, millis() 0.5% slow", 1.005, 1, 20, 3600, 30 },
+  { "busy loop, millis() 0.5% fast", 0.995, 1, 20, 3600, 30 },
+  { "slow loop, across midnight", 1.0, 1, 300, 86400 - 1800, 100 },
+  { "slow loop, millis() 0.5% slow", 1.005, 1, 300, 3600, 100 },
+  { "once a second", 1.0, 1000, 1000, 3600, 0 },
+  { "once a second, millis() 0.5% fast", 0.995, 1000, 1000, 3600, 0 },
+};
+
+static unsigned long hours = 2;
+
+static int run(const Case &c) {
+  DS3231 rtc;
+  rtcStart = c.start;
+  rtcPhase = rand() % 1000;
+  rtcRate = c.rate;
+  rtcReads = 0;
+  hostMillis = rand() % 100000;
+
+  unsigned long begin = hostMillis, end = begin + hours * 3600000UL, calls = 0, readsHomed = 0;
+  long worstLag = 0, worstLate = 0;
+  double lagSum = 0;
+  int ahead = 0, badMs = 0;
+  while ( hostMillis < end ) {
+    DS3231Snapshot t;
+    unsigned long readsBefore = rtcReads;
+    rtc.getCachedTime(t);
+    double truth = chipMs(hostMillis);
+    // what it says, as ms since midnight of day 1
+    double shown = (t.date - 1) * 86400000.0 + (t.hour * 3600L + t.minute * 60L + t.second) * 1000.0 + t.ms;
+    double lag = truth - shown;
+    // how long the chip has been on the next second while this still shows the last one
+    double late = truth - (shown - t.ms + 1000);
+    if ( t.ms > 999 ) badMs++;
+    if ( lag < 0 ) ahead++;
+    if ( hostMillis - begin > 10000 ) {
+      calls++;
+      lagSum += lag;
+      if ( lag > worstLag ) worstLag = (long)lag;
+      if ( late > worstLate ) worstLate = (long)late;
+      readsHomed += rtcReads - readsBefore;
+    }
+    hostMillis += c.gapMin + rand() % (c.gapMax - c.gapMin + 1);
+  }
+  double seconds = (end - begin - 10000) / 1000.0;
+  boolean ok = !ahead && !badMs && worstLate <= c.late;
+  printf("%-34s second late %3ld ms; ms behind %3ld, mean %5.1f; %.2f reads/s; %d ahead, %d bad ms%s\n", c.what,
+         worstLate, worstLag, calls ? lagSum / calls : 0, readsHomed / seconds, ahead, badMs, ok ? "" : "  FAIL");
+  return( ok ? 0 : 1 );
+}
+
+int main(int argc, char **argv) {
+  int ch;
+  unsigned int seed = 1;
+  while ( (ch = getopt(argc, argv, "h:r:")) != -1 ) {
+    switch ( ch ) {
+      case 'h': hours = strtoul(optarg, 0, 10); break;
+      case 'r': seed = strtoul(optarg, 0, 10); break;
+      default:
+        fprintf(stderr, "usage: rtccheck [-h hours] [-r seed]\n");
+        return 2;
+    }
+  }
+  if ( hours < 1 ) hours = 1;
+  srand(seed);
+
+  int failed = 0;
+  for (unsigned i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) failed += run(cases[i]);
+  printf(failed ? "%d cases failed\n" : "never ahead of the chip, and onto each second as soon as each case allows\n", failed);
+  return( failed ? 1 : 0 );
+}
@@ -0,0 +1,100 @@
+/*
+
+timecheck: check the Time library's incremental cache against breakTime() on a
+host, and time the two.
+
+Build:   g++ -O2 -o timecheck -I../host -I../../libraries/Time timecheck.cpp ../../libraries/Time/Time.cpp ../host/host.cpp
+
+Usage:   timecheck [-y years] [-j jumps]
+
+  -y years  every second from 1970 on, this many years of them (default 100,
+            to 2070; a few minutes)
+  -j jumps  then this many random steps and jumps, forward and back, so the
+            cache is refilled from breakTime() as well as advanced (default 5e7)
+
+Every second is read the way TimeAlarms reads it, hour(t), minute(t) and so
+on, and compared with breakTime(t).  breakTime() runs once a minute and the
+second is carried by hand in between, so the reference doesn't cost the
+year and month loops every second.  Exit status 1 on any mismatch.
+
+*/
+
+// no <stdlib.h> or <time.h>: both bring the host's time_t, which Time.h declares its own way
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/times.h>
+#include "Time.h"
+
+static unsigned long mismatches = 0;
+
+static void check(time_t t, const tmElements_t &r) {
+  if ( second(t) == r.Second && minute(t) == r.Minute && hour(t) == r.Hour && day(t) == r.Day &&
+       weekday(t) == r.Wday && month(t) == r.Month && year(t) == tmYearToCalendar(r.Year) ) return;
+  if ( ++mismatches <= 10 ) {
+    printf("mismatch at %lu: %d-%d-%d %d:%d:%d, breakTime() says %d-%d-%d %d:%d:%d\n", t,
+           year(t), month(t), day(t), hour(t), minute(t), second(t),
+           tmYearToCalendar(r.Year), r.Month, r.Day, r.Hour, r.Minute, r.Second);
+  }
+}
+
+// CPU seconds so far
+static double seconds() {
+  struct tms t;
+  times(&t);
+  return (double)t.tms_utime / sysconf(_SC_CLK_TCK);
+}
+
+int main(int argc, char **argv) {
+  unsigned long years = 100, jumps = 50000000UL;
+  int c;
+  while ( (c = getopt(argc, argv, "y:j:")) != -1 ) {
+    switch ( c ) {
+      case 'y': sscanf(optarg, "%lu", &years); break;
+      case 'j': sscanf(optarg, "%lu", &jumps); break;
+      default:
+        fprintf(stderr, "usage: timecheck [-y years] [-j jumps]\n");
+        return 2;
+    }
+  }
+
+  // every second
+  tmElements_t r;
+  tmElements_t start = { 0, 0, 0, 0, 1, 1, (uint8_t)years };
+  time_t end = makeTime(start);
+  for (time_t t = 0; t < end; t++) {
+    if ( t % 60 == 0 ) breakTime(t, r);
+    else r.Second++;
+    check(t, r);
+  }
+  printf("%lu seconds checked\n", end);
+
+  // steps of up to a day, longer jumps, and jumps back
+  unsigned long x = 12345;
+  time_t t = 0;
+  for (unsigned long i = 0; i < jumps; i++) {
+    x = x * 1103515245UL + 12345UL;
+    unsigned long step = (x >> 8) % 7 == 0 ? (x >> 4) % 200000UL : (x >> 4) % 100;
+    if ( (x >> 3) % 97 == 0 ) t = (x >> 2) % end;
+    else t = (t + step) % end;
+    breakTime(t, r);
+    check(t, r);
+  }
+  printf("%lu random steps checked, %lu mismatches\n", jumps, mismatches);
+
+  // a clock read every second, as TimeAlarms does: through the cache, and through
+  // breakTime() every time, which is what the cache used to do on every change
+  const time_t t0 = 1400000000UL, n = 100000000UL;
+  unsigned long sumA = 0, sumB = 0;
+  double s0 = seconds();
+  for (time_t t = t0; t < t0 + n; t++) sumA += hour(t) + minute(t) + second(t);
+  double s1 = seconds();
+  for (time_t t = t0; t < t0 + n; t++) {
+    breakTime(t, r);
+    sumB += r.Hour + r.Minute + r.Second;
+  }
+  double s2 = seconds();
+  printf("incremental %.1f ns/second, breakTime() %.1f ns/second%s\n",
+         (s1 - s0) * 1e9 / n, (s2 - s1) * 1e9 / n, sumA == sumB ? "" : " (sums differ)");
+
+  return( mismatches || sumA != sumB ? 1 : 0 );
+}